@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -6,60 +7,281 @@
 #include <time.h>
 #include <limits.h>
 #include <stdbool.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+// Log level, chosen at compile time with -DLOG_LEVEL=...
+// LOG_BENCH compiles every event log line out, LOG_TRACE logs events up to TRACE_WINDOW ms,
+// LOG_DEBUG also compiles in the event queue dump helpers
+#define LOG_BENCH 0
+#define LOG_TRACE 1
+#define LOG_DEBUG 2
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_TRACE
+#endif
+// Events after this time (ms) are not logged, -DTRACE_WINDOW=... to change
+#ifndef TRACE_WINDOW
+#define TRACE_WINDOW 10000
+#endif
+
+#if LOG_LEVEL >= LOG_TRACE
+#define LOGGING(out) ((out) != NULL)
+#define TRACING(out, time) ((out) != NULL && (time) <= TRACE_WINDOW)
+#else
+#define LOGGING(out) false
+#define TRACING(out, time) false
+#endif
+
+// Hot path counters and phase timers, compiled in with -DSTATS and printed with --stats
+// Without it STAT_ADD and STAT_MAX compile to nothing
+#ifdef STATS
+#define STAT_ADD(field, value) (simStats.field += (value))
+#define STAT_MAX(field, value) do { if ((value) > simStats.field) simStats.field = (value); } while (0)
+#else
+#define STAT_ADD(field, value) ((void)0)
+#define STAT_MAX(field, value) ((void)0)
+#endif
 
 typedef enum {ARRIVE, READY, RUNNING, PREEMPTION, ENQUEUE, WAITING, TERMINATED} State;
 
+// Workload of a process, generated once and shared read-only by every simulation
 typedef struct {
-    char* pid;
+    int id;             // Index in the workload, breaks ties between processes
+    const char* name;   // Name from an imported trace, NULL to derive it from id
     int arrivalTime;
-    int endTime;
     int numBursts;
-    int burstsLeft;
     int* cpuBursts;
     int* ioBursts;
+    int nice;           // CFS priority, -20 (highest) to 19
+    int* deadlines;     // Relative deadline of each CPU burst in ms, 0 for none; NULL when the workload has none
+} ProcessInfo;
+
+// Name of a process for logs and exports: A0..A9, B0..B9, ... Z9 for the first 260 processes, then P260, P261, ...
+// The returned buffer belongs to the calling thread and is reused after PID_NAME_SLOTS calls
+#define PID_NAME_SLOTS 4
+const char* pidName(const ProcessInfo* p) {
+    static __thread char names[PID_NAME_SLOTS][16];
+    static __thread int next;
+    if (p->name != NULL) {
+        return p->name;
+    }
+    char* name = names[next];
+    next = (next + 1) % PID_NAME_SLOTS;
+    if (p->id < 260) {
+        snprintf(name, sizeof(names[0]), "%c%d", 'A' + p->id / 10, p->id % 10);
+    } else {
+        snprintf(name, sizeof(names[0]), "P%d", p->id);
+    }
+    return name;
+}
+
+// CFS load weight of each nice value from -20 to 19, as in the Linux scheduler; every step is about 1.25x
+#define NICE_0_WEIGHT 1024
+#define CFS_GRANULARITY_DIVISOR 8   // Minimum granularity is the target latency over this, as Linux's 6ms / 0.75ms
+const int niceWeights[40] = {
+    88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+    9548, 7620, 6100, 4904, 3906, 3121, 2501, 1991, 1586, 1277,
+    1024, 820, 655, 526, 423, 335, 272, 215, 172, 137,
+    110, 87, 70, 56, 45, 36, 29, 23, 18, 15
+};
+
+int niceWeight(int nice) {
+    if (nice < -20) nice = -20;
+    if (nice > 19) nice = 19;
+    return niceWeights[nice + 20];
+}
+
+// State of a process during one simulation, each algorithm run owns its own copy
+// The states are one array of structs rather than parallel arrays per field: every queue and event refers to
+// a Process*, and moving the hottest field, the ready heap key, into an array beside the heap measured no faster.
+typedef struct Process {
+    const ProcessInfo* info;
+    int burstsLeft;
     int* remainingBursts;
     State state;
     int tau;
     // For writing to simout
     int readyTime;
     int wait;
+    int waitMark;       // wait at the end of the previous burst
     int startTime;
     int turnaround;
     int cs;
     // For RR
     int preemptions;
     int oneTS;
+    // For multi-core runs
+    int lastCore;
+    // Slot in the ready heap holding the process, -1 when it is in none, and its key there
+    int heapIndex;
+    long long heapKey;
+    // For CFS: load weight from nice, virtual runtime and links of the vruntime tree.
+    // Stride scheduling keeps its pass in vruntime and uses the same tree.
+    int weight;
+    long long vruntime;
+    struct Process* rbParent;
+    struct Process* rbLeft;
+    struct Process* rbRight;
+    bool rbRed;
+    // For MLFQ: queue level, which only holds while levelEpoch matches the scheduler's boost epoch
+    int level;
+    int levelEpoch;
+    // For stride and lottery: share of the CPU and the class it is reported in (0 CPU-bound, 1 I/O-bound).
+    // While other processes were ready, the CPU time it ran and how much of that time the tickets of each
+    // class were entitled to
+    int tickets;
+    int ticketClass;
+    int contendedTime;
+    double entitledTime[2];
+    // Completed CPU bursts that had a deadline, and those that missed it
+    int deadlineBursts;
+    int deadlineMisses;
 } Process;
 
 // Process: Process associated with the event
 // Time: timestamp when a process finishes its state
 // State: state of the process
-typedef struct {
+// Seq: insertion order, breaks ties between events with the same time and priority
+typedef struct Event {
     Process* process;
     int time;
     State state;
+    int64_t seq;                // 64 bit, a long run can create more than INT_MAX events
+    int core;                   // Multi-core runs: CPU the event happens on
+    int generation;             // Multi-core runs: CPU generation the event was scheduled in
+    struct Event* nextFree;     // Next slot in the free list while the event is unused
 } Event;
 
-// Create a new event
-Event* createEvent(Process* p, int time, State s){
-    Event* newEvent = malloc(sizeof(Event*));
-    newEvent->process = p;
-    newEvent->time = time;
-    newEvent->state = s;
-    return newEvent;
+// Work of the simulations run on the calling thread: events created and allocations made by the engine.
+// The benchmark takes the difference around each run.
+typedef struct {
+    long events;
+    long allocations;
+} SimCounters;
+
+_Thread_local SimCounters simCounters;
+
+// Allocators of the engine's data structures, counted in simCounters
+void* simMalloc(size_t size) {
+    simCounters.allocations++;
+    return malloc(size);
 }
 
+void* simCalloc(size_t count, size_t size) {
+    simCounters.allocations++;
+    return calloc(count, size);
+}
+
+void* simRealloc(void* p, size_t size) {
+    simCounters.allocations++;
+    return realloc(p, size);
+}
+
+#ifdef STATS
+// Work done in the data structures of the simulations run on the calling thread
+typedef struct {
+    long eventComparisons;          // Event heap order comparisons
+    long eventShifts;               // Events moved while sifting the event heap
+    long eventsByState[TERMINATED + 1];     // Events popped, stale ones included
+    int maxEvents;                  // Most events queued at once
+    long readyComparisons;          // Ready heap and vruntime tree order comparisons
+    long readyShifts;               // Ready heap sift moves, tree rotations and queue growth copies
+    int maxReady;                   // Most processes in one ready queue
+    double seconds;                 // Wall time of the simulation
+} SimStats;
+
+_Thread_local SimStats simStats;
+#endif
+
+// Events are carved out of slabs so the simulation loops do not malloc per event
+#define EVENT_SLAB_SIZE 256
+
+typedef struct EventSlab {
+    struct EventSlab* next;
+    Event events[EVENT_SLAB_SIZE];
+} EventSlab;
+
+// Binary min-heap of events ordered by (time, priority, insertion order)
+// The queue also owns the event pool, so every event of a simulation is released with the queue
 typedef struct {
     Event** events;
     int size;
     int capacity;
+    int64_t nextSeq;
+    // Event pool
+    EventSlab* slabs;
+    Event* freeEvents;
+    int slabAllocs;         // Number of mallocs done by the pool
+    long eventsCreated;     // Number of createEvent calls
+    int eventsInUse;        // Events created and not yet released
+    int peakEventsInUse;
 } EventQueue;
 
 // Initialize the event queue
 void initEventQueue(EventQueue* q, int capacity) {
-    q->events = calloc(capacity, sizeof(Event));
+    if (capacity < 1) capacity = 1;
+    q->events = simCalloc(capacity, sizeof(Event*));
     q->size = 0;
     q->capacity = capacity;
+    q->nextSeq = 0;
+    q->slabs = NULL;
+    q->freeEvents = NULL;
+    q->slabAllocs = 0;
+    q->eventsCreated = 0;
+    q->eventsInUse = 0;
+    q->peakEventsInUse = 0;
+}
+
+// Add a slab of unused events to the free list
+bool growEventPool(EventQueue* q) {
+    EventSlab* slab = simMalloc(sizeof(EventSlab));
+    if (slab == NULL) {
+        fprintf(stderr, "ERROR: Memory allocation failed for event pool\n");
+        return false;
+    }
+    slab->next = q->slabs;
+    q->slabs = slab;
+    q->slabAllocs++;
+    for (int i = EVENT_SLAB_SIZE - 1; i >= 0; i--) {
+        slab->events[i].nextFree = q->freeEvents;
+        q->freeEvents = &slab->events[i];
+    }
+    return true;
+}
+
+// Create a new event from the queue's pool
+Event* createEvent(EventQueue* q, Process* p, int time, State s){
+    if (q->freeEvents == NULL && !growEventPool(q)) {
+        return NULL;
+    }
+    Event* newEvent = q->freeEvents;
+    q->freeEvents = newEvent->nextFree;
+    newEvent->process = p;
+    newEvent->time = time;
+    newEvent->state = s;
+    newEvent->seq = 0;
+    newEvent->core = 0;
+    newEvent->generation = 0;
+    newEvent->nextFree = NULL;
+
+    q->eventsCreated++;
+    q->eventsInUse++;
+    if (q->eventsInUse > q->peakEventsInUse) {
+        q->peakEventsInUse = q->eventsInUse;
+    }
+    return newEvent;
+}
+
+// Return a handled event to the queue's pool
+void releaseEvent(EventQueue* q, Event* e){
+    e->nextFree = q->freeEvents;
+    q->freeEvents = e;
+    q->eventsInUse--;
 }
 
 // Helper function to assign a priority based on the event state.
@@ -76,45 +298,49 @@ int getEventPriority(int state) {
         return 4;
     }
 }
-// Insert an event into the event queue for FCFS
-void insertEventFCFS(EventQueue* q, Event* event) {
-    if (q->size >= q->capacity) {
-        fprintf(stderr, "ERROR: EventQueue is full. Cannot insert event.\n");
-        return;
+
+// Returns true if event a is handled before event b
+bool eventBefore(Event* a, Event* b) {
+    STAT_ADD(eventComparisons, 1);
+    if (a->time != b->time) {
+        return a->time < b->time;
     }
-    
-    int insertIndex = q->size;  // Default to inserting at the end
+    int aPriority = getEventPriority(a->state);
+    int bPriority = getEventPriority(b->state);
+    if (aPriority != bPriority) {
+        return aPriority < bPriority;
+    }
+    // Same time and priority: first inserted is handled first
+    return a->seq < b->seq;
+}
 
-    // Find the correct position to insert while keeping order
-    for (int i = 0; i < q->size; i++) {
-        if (q->events[i]->time > event->time) {
-            insertIndex = i;
-            break;
-        } 
-        else if (event->time == q->events[i]->time) {
-            int eventPriority = getEventPriority(event->state);
-            int curPriority = getEventPriority(q->events[i]->state);
-            if (eventPriority < curPriority) {
-                // Event has higher priority (lower numerical value).
-                insertIndex = i;
-                break;
-            } else if (eventPriority < curPriority){
-                if (strcmp(event->process->pid, q->events[i]->process->pid) < 0) {
-                    insertIndex = i;
-                    break;
-                }
-            }
+// Insert an event into the event queue, growing it if needed
+void insertEvent(EventQueue* q, Event* event) {
+    if (q->size >= q->capacity) {
+        int newCapacity = q->capacity * 2;
+        Event** grown = simRealloc(q->events, newCapacity * sizeof(Event*));
+        if (grown == NULL) {
+            fprintf(stderr, "ERROR: Memory allocation failed for event queue\n");
+            return;
         }
+        q->events = grown;
+        q->capacity = newCapacity;
     }
+    event->seq = q->nextSeq++;
 
-    // Shift all events **after insertIndex** one position to the right
-    for (int j = q->size; j > insertIndex; j--) {
-        q->events[j] = q->events[j - 1];
+    // Sift up from the new leaf
+    int i = q->size++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!eventBefore(event, q->events[parent])) {
+            break;
+        }
+        q->events[i] = q->events[parent];
+        STAT_ADD(eventShifts, 1);
+        i = parent;
     }
-
-    // Insert the new event at the correct position
-    q->events[insertIndex] = event;
-    q->size++;
+    q->events[i] = event;
+    STAT_MAX(maxEvents, q->size);
 }
 
 
@@ -123,1318 +349,4707 @@ Event* popEvent(EventQueue* q) {
     if (q->size == 0) return NULL;
     Event* event = q->events[0];
     q->size--;
-    for (int i = 0; i < q->size; i++) {
-        q->events[i] = q->events[i + 1];
+    if (q->size == 0) return event;
+
+    // Sift the last leaf down from the root
+    Event* last = q->events[q->size];
+    int i = 0;
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= q->size) {
+            break;
+        }
+        if (child + 1 < q->size && eventBefore(q->events[child + 1], q->events[child])) {
+            child++;
+        }
+        if (!eventBefore(q->events[child], last)) {
+            break;
+        }
+        q->events[i] = q->events[child];
+        STAT_ADD(eventShifts, 1);
+        i = child;
     }
+    q->events[i] = last;
     return event;
 }
 
 
-// Free all events in the EventQueue and then the array itself.
+// Free the event pool and the heap array. Events still queued belong to the pool, so they go with it.
 void freeEventQueue(EventQueue* q) {
     if (q == NULL) return;
-    // Free each individual event
-    for (int i = 0; i < q->size; i++) {
-        if (q->events[i]){
-            free(q->events[i]);
-        }
+    while (q->slabs != NULL) {
+        EventSlab* next = q->slabs->next;
+        free(q->slabs);
+        q->slabs = next;
     }
+    q->freeEvents = NULL;
     // Free the events array
     free(q->events);
     q->events = NULL;
     q->size = 0;
     q->capacity = 0;
 }
-// For debugging
+#if LOG_LEVEL >= LOG_DEBUG || defined(STATS)
+// For debugging and the --stats summary
 const char* stateToString(State s) {
     switch (s) {
         case ARRIVE:      return "ARRIVE";
         case READY:       return "READY";
         case RUNNING:     return "RUNNING";
         case PREEMPTION:  return "PREEMPTION";
+        case ENQUEUE:     return "ENQUEUE";
         case WAITING:     return "WAITING";
         case TERMINATED:  return "TERMINATED";
         default:          return "UNKNOWN";
     }
 }
+#endif
 
-void printEventQueue(EventQueue* q) {
+#if LOG_LEVEL >= LOG_DEBUG
+
+void printEventQueue(FILE* out, EventQueue* q) {
     if (q->size == 0) {
-        printf("[Q empty]\n");
+        fprintf(out, "[Q empty]\n");
         return;
     }
     
-    printf("Event Queue: ");
+    fprintf(out, "Event Queue: ");
     for (int i = 0; i < q->size; i++) {
         Event* e = q->events[i];
-        printf("[Time: %d, Process: %s, State: %s]", e->time, e->process->pid, stateToString(e->state));
+        fprintf(out, "[Time: %d, Process: %s, State: %s]", e->time, pidName(e->process->info), stateToString(e->state));
     }
-    printf("\n");
+    fprintf(out, "\n");
+}
+
+// Allocation counters of the event pool; slab allocations stop growing once the simulation reaches steady state
+void printEventPoolStats(FILE* out, EventQueue* q) {
+    fprintf(out, "Event Pool: %ld events created, %d in use (peak %d), %d slab allocations of %d events\n",
+        q->eventsCreated, q->eventsInUse, q->peakEventsInUse, q->slabAllocs, EVENT_SLAB_SIZE);
 }
+#endif
 
 
 // Queue DS
+// Circular buffer: the front of the queue is procs[head] and elements wrap around capacity
 typedef struct {
     Process **procs;
+    int head;
     int size;
     int capacity;
 } Queue;
 
 // Initialize queue
 void initQueue(Queue *q, int capacity) {
-    q->procs = calloc(capacity + 1, sizeof(Process *));
+    if (capacity < 1) capacity = 1;
+    q->procs = simCalloc(capacity, sizeof(Process *));
     if (q->procs == NULL) {
         fprintf(stderr, "ERROR: Memory allocation failed for queue\n");
         return;
     }
+    q->head = 0;
     q->size = 0;
     q->capacity = capacity;
 }
 
+// Get the slot in procs of the i-th element from the front of the queue
+int queueIndex(Queue *q, int i) {
+    int index = q->head + i;
+    if (index >= q->capacity) {
+        index -= q->capacity;
+    }
+    return index;
+}
+
+// Double the capacity, unwrapping the elements so the front is at procs[0]
+bool growQueue(Queue *q) {
+    int newCapacity = q->capacity * 2;
+    Process **grown = simCalloc(newCapacity, sizeof(Process *));
+    if (grown == NULL) {
+        fprintf(stderr, "ERROR: Memory allocation failed for queue\n");
+        return false;
+    }
+    for (int i = 0; i < q->size; i++) {
+        grown[i] = q->procs[queueIndex(q, i)];
+    }
+    STAT_ADD(readyShifts, q->size);
+    free(q->procs);
+    q->procs = grown;
+    q->head = 0;
+    q->capacity = newCapacity;
+    return true;
+}
+
 // Add to queue
-void enqueue(Queue *q, Process *p, int time) {
-    if (q->size < q->capacity) {
-        *(q->procs + q->size) = p;
-        q->size++;
-    } else {
-        fprintf(stderr, "ERROR: Queue is full, cannot enqueue %s at time %dms\n", p->pid, time);
+void enqueue(Queue *q, Process *p) {
+    if (q->size >= q->capacity && !growQueue(q)) {
         return;
     }
+    q->procs[queueIndex(q, q->size)] = p;
+    q->size++;
+    STAT_MAX(maxReady, q->size);
+}
+
+// Process at the front of the queue, NULL if empty
+Process* peekQueue(Queue *q) {
+    if (q->size == 0) return NULL;
+    return q->procs[q->head];
 }
 
 Process* dequeue(Queue *q) {
     if (q->size == 0) return NULL;
-    Process *p = *(q->procs);
-    // Shift elements left
-    Process **cur = q->procs;
-    for (int i = 0; i < q->size - 1; i++) {
-        *(cur + i) = *(cur + i + 1);
-    }
+    Process *p = q->procs[q->head];
+    q->head = queueIndex(q, 1);
     q->size--;
     return p;
 }
 
-void printQueue(Queue *q) {
+void printQueue(FILE* out, Queue *q) {
     if (q->size == 0) {
-        printf(" empty");
+        fprintf(out, " empty");
     } else {
-        Process **cur = q->procs;
         for (int i = 0; i < q->size; i++) {
-            printf(" %s", (*(cur + i))->pid);
+            fprintf(out, " %s", pidName(q->procs[queueIndex(q, i)]->info));
         }
     }
 }
 
 
-// Get the time that the cpu is free based on 
-int getTimeOfLastEvent(EventQueue* eq, int time, int tslice){
-    if (eq->size == 0){
-        return time;
+// Ready heap
+// Indexed 4-ary min-heap of processes keyed by (heapKey, id): the predicted remaining time for SJF and SRT,
+// the absolute deadline for EDF. The key is cached in the process when it is pushed, so comparisons do not
+// recompute it; each process remembers its slot in heapIndex while it is queued.
+#define HEAP_ARITY 4
+
+typedef struct {
+    Process** procs;
+    int size;
+    int capacity;
+} ReadyHeap;
+
+void initReadyHeap(ReadyHeap* h, int capacity) {
+    if (capacity < 1) capacity = 1;
+    h->procs = simCalloc(capacity, sizeof(Process*));
+    if (h->procs == NULL) {
+        fprintf(stderr, "ERROR: Memory allocation failed for ready heap\n");
+        return;
+    }
+    h->size = 0;
+    h->capacity = capacity;
+}
+
+// Predicted time left in the process's next or current burst: tau less what it already ran of it
+int predictedRemaining(const Process* p) {
+    int idx = p->info->numBursts - p->burstsLeft;
+    return p->tau - (p->info->cpuBursts[idx] - p->remainingBursts[idx]);
+}
+
+// Order of the ready queue: key, then process id
+bool readyBefore(const Process* a, const Process* b) {
+    STAT_ADD(readyComparisons, 1);
+    if (a->heapKey != b->heapKey) return a->heapKey < b->heapKey;
+    return a->info->id < b->info->id;
+}
+
+void heapPlace(ReadyHeap* h, int i, Process* p) {
+    h->procs[i] = p;
+    p->heapIndex = i;
+}
+
+void heapSiftUp(ReadyHeap* h, int i) {
+    Process* p = h->procs[i];
+    while (i > 0) {
+        int parent = (i - 1) / HEAP_ARITY;
+        if (!readyBefore(p, h->procs[parent])) break;
+        heapPlace(h, i, h->procs[parent]);
+        STAT_ADD(readyShifts, 1);
+        i = parent;
     }
+    heapPlace(h, i, p);
+}
 
-    for (int i = eq->size-1; i >= 0; i--){
-        if (eq->events[i]->state != WAITING && eq->events[i]->state != ARRIVE){
-            int burstRem = eq->events[i]->process->remainingBursts[eq->events[i]->process->numBursts - eq->events[i]->process->burstsLeft];
-            if (burstRem <= tslice){
-                return eq->events[i]->time + burstRem;
-            } else {
-                return eq->events[i]->time + tslice;
-            }
+void heapSiftDown(ReadyHeap* h, int i) {
+    Process* p = h->procs[i];
+    while (true) {
+        int first = HEAP_ARITY * i + 1;
+        if (first >= h->size) break;
+        int best = first;
+        int last = first + HEAP_ARITY < h->size ? first + HEAP_ARITY : h->size;
+        for (int c = first + 1; c < last; c++) {
+            if (readyBefore(h->procs[c], h->procs[best])) best = c;
         }
+        if (!readyBefore(h->procs[best], p)) break;
+        heapPlace(h, i, h->procs[best]);
+        STAT_ADD(readyShifts, 1);
+        i = best;
     }
-    return time;
+    heapPlace(h, i, p);
 }
 
-// First Come First Serve
-int FCFS(Process** processes, int n, int tcs) {
-    // Reset all processes
-    for (int i = 0; i < n; i++) {
-        (*(processes+i))->state = ARRIVE;
-        (*(processes+i))->burstsLeft = (*(processes+i))->numBursts;
-        for (int j = 0; j < (*(processes+i))->numBursts; j++){
-            (*(processes+i))->remainingBursts[j] = (*(processes+i))->cpuBursts[j];
+void readyHeapPush(ReadyHeap* h, Process* p, long long key) {
+    p->heapKey = key;
+    if (h->size >= h->capacity) {
+        Process** grown = simRealloc(h->procs, 2 * h->capacity * sizeof(Process*));
+        if (grown == NULL) {
+            fprintf(stderr, "ERROR: Memory allocation failed for ready heap\n");
+            return;
         }
-        // For writing to simout
-        (*(processes+i))->readyTime = 0;
-        (*(processes+i))->wait = 0;
-        (*(processes+i))->startTime = 0;
-        (*(processes+i))->turnaround = 0;
-        (*(processes+i))->cs = 0;
+        h->procs = grown;
+        h->capacity *= 2;
     }
+    h->procs[h->size] = p;
+    heapSiftUp(h, h->size++);
+    STAT_MAX(maxReady, h->size);
+}
 
+// Process with the smallest key, NULL if empty
+Process* readyHeapPeek(ReadyHeap* h) {
+    if (h->size == 0) return NULL;
+    return h->procs[0];
+}
 
-    // Start Simultaion
-    Queue q;
-    initQueue(&q, n);
-    EventQueue eq;
-    initEventQueue(&eq, n);
-    printf("time 0ms: Simulator started for FCFS [Q empty]\n");
+// Take the process at slot i out of the heap
+void readyHeapRemoveAt(ReadyHeap* h, int i) {
+    Process* p = h->procs[i];
+    p->heapIndex = -1;
+    h->size--;
+    if (i == h->size) return;
+    Process* moved = h->procs[h->size];
+    heapPlace(h, i, moved);
+    // The moved process may belong above or below slot i
+    heapSiftUp(h, i);
+    heapSiftDown(h, moved->heapIndex);
+}
 
-    // Arrivals
-    for (int i = 0; i < n; i++){
-        Event* newEvent = createEvent(*(processes+i), (*(processes+i))->arrivalTime, ARRIVE);
-        insertEventFCFS(&eq, newEvent);
+Process* readyHeapPop(ReadyHeap* h) {
+    if (h->size == 0) return NULL;
+    Process* p = h->procs[0];
+    readyHeapRemoveAt(h, 0);
+    return p;
+}
+
+int compareReady(const void* a, const void* b) {
+    const Process* p = *(Process* const*)a;
+    const Process* q = *(Process* const*)b;
+    return readyBefore(p, q) ? -1 : readyBefore(q, p) ? 1 : 0;
+}
+
+// Print the queued processes in the order they will run; only used for logging
+void printReadyHeap(FILE* out, ReadyHeap* h) {
+    if (h->size == 0) {
+        fprintf(out, " empty");
+        return;
+    }
+    Process** sorted = malloc(h->size * sizeof(Process*));
+    if (sorted == NULL) {
+        fprintf(stderr, "ERROR: Memory allocation failed for ready queue listing\n");
+        return;
+    }
+    memcpy(sorted, h->procs, h->size * sizeof(Process*));
+    qsort(sorted, h->size, sizeof(Process*), compareReady);
+    for (int i = 0; i < h->size; i++) {
+        fprintf(out, " %s", pidName(sorted[i]->info));
     }
+    free(sorted);
+}
 
-    int time = 0;
-    int terminatedCount = 0;
-    int cpuFreeAt = 0;
-    int cpuIdle = -1;
-    while (terminatedCount < n) {
-        // Handle Events
-        Event* e = popEvent(&eq);
-        time = e->time;
+// Vruntime tree
+// Intrusive red-black tree of processes keyed by (vruntime, id), the CFS ready queue.
+// The links live in Process, so insert and remove allocate nothing; the minimum is cached in leftmost.
+typedef struct {
+    Process* root;
+    Process* leftmost;
+    int size;
+    long totalWeight;   // Sum of the weights of the queued processes
+} VruntimeTree;
 
-        // Arrival
-        if (e->state == ARRIVE){
-            // Print and add to queue
-            enqueue(&q, e->process, time);
-            // Print
-            if (time <= 10000){
-                printf("time %dms: Process %s arrived; added to ready queue [Q", time, e->process->pid);
-                printQueue(&q);
-                printf("]\n");
-            }
+// Order of the tree: virtual runtime, then process id
+bool vruntimeBefore(const Process* a, const Process* b) {
+    STAT_ADD(readyComparisons, 1);
+    if (a->vruntime != b->vruntime) return a->vruntime < b->vruntime;
+    return a->info->id < b->info->id;
+}
 
-            // Create a CPU burst event
-            // CPU is free
-            if (cpuIdle == -1 && time >= cpuFreeAt){
-                Event* newEvent = createEvent(e->process, time + tcs/2, READY);
-                insertEventFCFS(&eq, newEvent);
-                cpuFreeAt = time + e->process->cpuBursts[e->process->numBursts - e->process->burstsLeft] + tcs/2;
-                dequeue(&q);
-            }
-            // CPU is not free
-            else{
-                Event* newEvent = createEvent(e->process, cpuFreeAt + tcs, READY);
-                insertEventFCFS(&eq, newEvent);
-                cpuFreeAt += e->process->cpuBursts[e->process->numBursts - e->process->burstsLeft] + tcs;
-            }
+bool rbIsRed(const Process* p) {
+    return p != NULL && p->rbRed;
+}
 
-            // For writing to simout
-            e->process->startTime = time + tcs/2;   // Turnaround time
-            e->process->readyTime = time;           // Wait time
+// Put child where p hangs from its parent
+void rbReplace(VruntimeTree* t, Process* p, Process* child) {
+    if (p->rbParent == NULL) {
+        t->root = child;
+    } else if (p == p->rbParent->rbLeft) {
+        p->rbParent->rbLeft = child;
+    } else {
+        p->rbParent->rbRight = child;
+    }
+    if (child != NULL) {
+        child->rbParent = p->rbParent;
+    }
+}
+
+void rbRotateLeft(VruntimeTree* t, Process* p) {
+    STAT_ADD(readyShifts, 1);
+    Process* r = p->rbRight;
+    p->rbRight = r->rbLeft;
+    if (r->rbLeft != NULL) {
+        r->rbLeft->rbParent = p;
+    }
+    rbReplace(t, p, r);
+    r->rbLeft = p;
+    p->rbParent = r;
+}
+
+void rbRotateRight(VruntimeTree* t, Process* p) {
+    STAT_ADD(readyShifts, 1);
+    Process* l = p->rbLeft;
+    p->rbLeft = l->rbRight;
+    if (l->rbRight != NULL) {
+        l->rbRight->rbParent = p;
+    }
+    rbReplace(t, p, l);
+    l->rbRight = p;
+    p->rbParent = l;
+}
+
+// In-order successor, NULL for the last process
+Process* rbNext(Process* p) {
+    if (p->rbRight != NULL) {
+        p = p->rbRight;
+        while (p->rbLeft != NULL) p = p->rbLeft;
+        return p;
+    }
+    while (p->rbParent != NULL && p == p->rbParent->rbRight) {
+        p = p->rbParent;
+    }
+    return p->rbParent;
+}
+
+void treeInsert(VruntimeTree* t, Process* p) {
+    Process* parent = NULL;
+    Process** link = &t->root;
+    bool leftmost = true;
+    while (*link != NULL) {
+        parent = *link;
+        if (vruntimeBefore(p, parent)) {
+            link = &parent->rbLeft;
+        } else {
+            link = &parent->rbRight;
+            leftmost = false;
         }
-        // Start CPU Burst
-        else if (e->state == READY){
-            e->process->cs++;                                           // Context Switch
-            e->process->wait += time - e->process->readyTime - tcs/2;   // Wait time
-            cpuIdle = 0;
+    }
+    p->rbParent = parent;
+    p->rbLeft = NULL;
+    p->rbRight = NULL;
+    p->rbRed = true;
+    *link = p;
+    if (leftmost) {
+        t->leftmost = p;
+    }
+    t->size++;
+    t->totalWeight += p->weight;
+    STAT_MAX(maxReady, t->size);
 
-            if (e->process->pid == q.procs[0]->pid){
-                dequeue(&q);
+    // Restore the red-black properties, the parent of a red node is never the root
+    while (rbIsRed(p->rbParent)) {
+        Process* parent = p->rbParent;
+        Process* grand = parent->rbParent;
+        if (parent == grand->rbLeft) {
+            Process* uncle = grand->rbRight;
+            if (rbIsRed(uncle)) {
+                parent->rbRed = false;
+                uncle->rbRed = false;
+                grand->rbRed = true;
+                p = grand;
+                continue;
             }
-            int burstTime = *(e->process->cpuBursts + (e->process->numBursts - e->process->burstsLeft));
-            // Print
-            if (time <= 10000){
-                printf("time %dms: Process %s started using the CPU for %dms burst [Q", time, e->process->pid, burstTime);
-                printQueue(&q);
-                printf("]\n");
+            if (p == parent->rbRight) {
+                rbRotateLeft(t, parent);
+                parent = p;
             }
-
-            e->process->burstsLeft--;
-            if (e->process->burstsLeft == 0){
-                Event* endCpu = createEvent(e->process, time + burstTime, TERMINATED);
-                insertEventFCFS(&eq, endCpu);
-            } else{
-                Event* endCpu = createEvent(e->process, time + burstTime, RUNNING);
-                insertEventFCFS(&eq, endCpu);
+            parent->rbRed = false;
+            grand->rbRed = true;
+            rbRotateRight(t, grand);
+            break;
+        } else {
+            Process* uncle = grand->rbLeft;
+            if (rbIsRed(uncle)) {
+                parent->rbRed = false;
+                uncle->rbRed = false;
+                grand->rbRed = true;
+                p = grand;
+                continue;
             }
-            // updated the time when the CPU is free
-            if (cpuFreeAt < time + burstTime){
-                cpuFreeAt = time + burstTime;
+            if (p == parent->rbLeft) {
+                rbRotateRight(t, parent);
+                parent = p;
             }
+            parent->rbRed = false;
+            grand->rbRed = true;
+            rbRotateLeft(t, grand);
+            break;
         }
-        // CPU Burst complete
-        else if(e->state == RUNNING){
-            e->process->turnaround += time + (tcs/2) - e->process->startTime;   // Turnaround time
+    }
+    t->root->rbRed = false;
+}
 
-            // CPU Burst complete
-            cpuIdle = -1;
+void treeRemove(VruntimeTree* t, Process* p) {
+    if (t->leftmost == p) {
+        t->leftmost = rbNext(p);
+    }
+    t->size--;
+    t->totalWeight -= p->weight;
 
-            // Print
-            if (time <= 10000){
-                if (e->process->burstsLeft == 1){
-                    printf("time %dms: Process %s completed a CPU burst; %d burst to go [Q", time, e->process->pid, e->process->burstsLeft);
-                } else{
-                    printf("time %dms: Process %s completed a CPU burst; %d bursts to go [Q", time, e->process->pid, e->process->burstsLeft);
-                }
-                printQueue(&q);
-                printf("]\n");
-            }
+    // Unlink p, or its successor when it has two children; child takes the unlinked node's place
+    Process* child;
+    Process* parent;
+    bool removedRed;
+    if (p->rbLeft == NULL || p->rbRight == NULL) {
+        child = p->rbLeft != NULL ? p->rbLeft : p->rbRight;
+        parent = p->rbParent;
+        removedRed = p->rbRed;
+        rbReplace(t, p, child);
+    } else {
+        Process* next = p->rbRight;
+        while (next->rbLeft != NULL) next = next->rbLeft;
+        removedRed = next->rbRed;
+        child = next->rbRight;
+        if (next->rbParent == p) {
+            parent = next;
+        } else {
+            parent = next->rbParent;
+            rbReplace(t, next, child);
+            next->rbRight = p->rbRight;
+            next->rbRight->rbParent = next;
+        }
+        rbReplace(t, p, next);
+        next->rbLeft = p->rbLeft;
+        next->rbLeft->rbParent = next;
+        next->rbRed = p->rbRed;
+    }
+    if (removedRed) {
+        return;
+    }
 
-            // IO Burst start
-            int ioCompTime = time + *(e->process->ioBursts+(e->process->numBursts - e->process->burstsLeft - 1)) + tcs/2;
-            // Print
-            if (time <= 10000){
-                printf("time %dms: Process %s switching out of CPU; blocking on I/O until time %dms [Q", time, e->process->pid, ioCompTime);
-                printQueue(&q);
-                printf("]\n");
+    // A black node was removed: child's side is one black short
+    while (child != t->root && !rbIsRed(child)) {
+        if (child == parent->rbLeft) {
+            Process* sibling = parent->rbRight;
+            if (sibling->rbRed) {
+                sibling->rbRed = false;
+                parent->rbRed = true;
+                rbRotateLeft(t, parent);
+                sibling = parent->rbRight;
             }
-            Event* ioBurst = createEvent(e->process, ioCompTime, WAITING);
-            insertEventFCFS(&eq, ioBurst);
-        }
-        // IO End
-        else if (e->state == WAITING){
-            if (cpuIdle == -1 && eq.events[0]->time - tcs/2 <= time){
-                dequeue(&q);
+            if (!rbIsRed(sibling->rbLeft) && !rbIsRed(sibling->rbRight)) {
+                sibling->rbRed = true;
+                child = parent;
+                parent = child->rbParent;
+                continue;
             }
-            enqueue(&q, e->process, time);
-
-            // Print
-            if (time <= 10000){
-                printf("time %dms: Process %s completed I/O; added to ready queue [Q", time, e->process->pid);
-                printQueue(&q);
-                printf("]\n");
-            }
-
-            // Get the burst time of the last process ready to run
-            if (q.size == 1 && cpuIdle == -1){
-                cpuFreeAt = time;
-                Event* cpuBurst = createEvent(e->process, cpuFreeAt + tcs/2, READY);
-                insertEventFCFS(&eq, cpuBurst);
-            } else if (q.size > 1){
-                int lastProcBurst = time;
-                for (int i = eq.size; i > 0; i--){
-                    if (eq.events[i]->state == READY){
-                        lastProcBurst = eq.events[i]->time + eq.events[i]->process->cpuBursts[eq.events[i]->process->numBursts - eq.events[i]->process->burstsLeft];
-                        break;
-                    }
-                }
-                
-                // Creates an event while considering CPU Bursts times in the queue
-                Event* cpuBurst = createEvent(e->process, lastProcBurst + tcs, READY);
-                insertEventFCFS(&eq, cpuBurst);
-                int burstTime = e->process->cpuBursts[e->process->numBursts - e->process->burstsLeft];
-                cpuFreeAt = lastProcBurst + burstTime + tcs;
-            } else {
-                Event* cpuBurst = createEvent(e->process, cpuFreeAt + tcs, READY);
-                insertEventFCFS(&eq, cpuBurst);
+            if (!rbIsRed(sibling->rbRight)) {
+                sibling->rbLeft->rbRed = false;
+                sibling->rbRed = true;
+                rbRotateRight(t, sibling);
+                sibling = parent->rbRight;
             }
-
-            // For writing to simout
-            e->process->startTime = time;   // Turnaround time
-            e->process->readyTime = time;   // Wait time
-        }
-        // Termination
-        else if (e->state == TERMINATED){
-            e->process->turnaround += time + tcs - e->process->startTime; // Turnaround time
-            cpuIdle = -1;
-            printf("time %dms: Process %s terminated [Q", time, e->process->pid);
-            printQueue(&q);
-            printf("]\n");
-            terminatedCount++;
+            sibling->rbRed = parent->rbRed;
+            parent->rbRed = false;
+            sibling->rbRight->rbRed = false;
+            rbRotateLeft(t, parent);
+        } else {
+            Process* sibling = parent->rbLeft;
+            if (sibling->rbRed) {
+                sibling->rbRed = false;
+                parent->rbRed = true;
+                rbRotateRight(t, parent);
+                sibling = parent->rbLeft;
+            }
+            if (!rbIsRed(sibling->rbLeft) && !rbIsRed(sibling->rbRight)) {
+                sibling->rbRed = true;
+                child = parent;
+                parent = child->rbParent;
+                continue;
+            }
+            if (!rbIsRed(sibling->rbLeft)) {
+                sibling->rbRight->rbRed = false;
+                sibling->rbRed = true;
+                rbRotateLeft(t, sibling);
+                sibling = parent->rbLeft;
+            }
+            sibling->rbRed = parent->rbRed;
+            parent->rbRed = false;
+            sibling->rbLeft->rbRed = false;
+            rbRotateRight(t, parent);
         }
-        free(e);
+        child = t->root;
+    }
+    if (child != NULL) {
+        child->rbRed = false;
     }
-    time += tcs/2;
-    printf("time %dms: Simulator ended for FCFS [Q empty]\n\n", time);
-    freeEventQueue(&eq);
-    free(q.procs);
-    return time;
 }
 
-
-//----------------------------------------------------------------------------------------------------------------------------
-
-// Inserts a process into the ready queue in sorted order (by tau, then PID) returns true if process is inserted in the middle of the queue returns false if the process is insert at the end of queue 
-
-bool enqueueSJF(Queue* q, Process* p) {
-    if (q->size >= q->capacity) {
-        fprintf(stderr, "ERROR: Queue is full, cannot enqueue %s\n", p->pid);
-        return false;
+// Remove and return the process with the least vruntime, NULL if the tree is empty
+Process* treePop(VruntimeTree* t) {
+    Process* p = t->leftmost;
+    if (p != NULL) {
+        treeRemove(t, p);
     }
-    int insertIndex = q->size;
-    for (int i = 0; i < q->size; i++) {
-        if (p->tau < q->procs[i]->tau ||
-           (p->tau == q->procs[i]->tau && strcmp(p->pid, q->procs[i]->pid) < 0)) {
-            insertIndex = i;
-            break;
-        }
+    return p;
+}
+
+// Print the queued processes in vruntime order
+void printVruntimeTree(FILE* out, VruntimeTree* t) {
+    if (t->size == 0) {
+        fprintf(out, " empty");
+        return;
     }
-    // Shift elements rightward to make space for the new process
-    for (int j = q->size; j > insertIndex; j--) {
-        q->procs[j] = q->procs[j-1];
+    for (Process* p = t->leftmost; p != NULL; p = rbNext(p)) {
+        fprintf(out, " %s", pidName(p->info));
     }
-    q->procs[insertIndex] = p;
-    q->size++;
-    return (insertIndex != q->size - 1);
+}
+
+// Ticket tree
+// Fenwick tree over process ids holding the tickets of the ready processes, the lottery ready queue.
+// Adding, removing and drawing a winner are O(log n); the processes are kept by id for the draw.
+typedef struct {
+    long* sums;         // sums[i] covers the ids (i - (i & -i), i], 1-based
+    Process** procs;    // Ready process of each id, NULL when it is not ready
+    int n;
+    int size;
+    long total;         // Tickets of all ready processes
+} TicketTree;
 
+void initTicketTree(TicketTree* t, int n) {
+    t->sums = simCalloc(n + 1, sizeof(long));
+    t->procs = simCalloc(n > 0 ? n : 1, sizeof(Process*));
+    if (t->sums == NULL || t->procs == NULL) {
+        fprintf(stderr, "ERROR: Memory allocation failed for ticket tree\n");
+        exit(EXIT_FAILURE);
+    }
+    t->n = n;
+    t->size = 0;
+    t->total = 0;
 }
 
-void updateProcessOrder(EventQueue* eq, Event* event, int insertIndex, int tcs) {
-	// update next process times = prevProcTime + burstTimeOfProcess + tcs
-	int prevProcTime = eq->events[insertIndex]->time; // 6661
-	event->time = prevProcTime;
-	int burstTime = 0;
-	for (int i = insertIndex; i < eq->size; i++) {
-        if (eq->events[i]->state == READY) {
-        // a5 in q = 6661 + BURSTTIMEOFa4 + tcs
-        	burstTime = event->process->cpuBursts[event->process->numBursts - event->process->burstsLeft];
-			eq->events[i]->time = prevProcTime + burstTime + tcs;
-			prevProcTime = eq->events[i]->time;
-        }       
-    }    
+void freeTicketTree(TicketTree* t) {
+    free(t->sums);
+    free(t->procs);
 }
 
-// Removes and returns the event at the specified index in the event queue.
-Event* removeEventSJF(EventQueue* q, int index) {
-    if (index < 0 || index >= q->size)
-        return NULL;
-    Event* removedEvent = q->events[index];
-    for (int i = index; i < q->size - 1; i++) {
-        q->events[i] = q->events[i + 1];
+void ticketAdd(TicketTree* t, int id, long tickets) {
+    for (int i = id + 1; i <= t->n; i += i & -i) {
+        t->sums[i] += tickets;
     }
-    q->size--;
-    return removedEvent;
+    t->total += tickets;
 }
 
-// New function for inserting events in SJF order in the event queue.
-// For events with state READY, if they have the same event time,
-// we compare their process's tau values (and use PID as a tie-breaker).
-bool insertEventSJF(EventQueue* eq, Event* event, int tcs) {
-    if (eq->size >= eq->capacity) {
-        fprintf(stderr, "ERROR: EventQueue is full. Cannot insert event.\n");
-        return false;
+void ticketInsert(TicketTree* t, Process* p) {
+    t->procs[p->info->id] = p;
+    t->size++;
+    ticketAdd(t, p->info->id, p->tickets);
+    STAT_MAX(maxReady, t->size);
+}
+
+void ticketRemove(TicketTree* t, Process* p) {
+    t->procs[p->info->id] = NULL;
+    t->size--;
+    ticketAdd(t, p->info->id, -p->tickets);
+}
+
+// Ready process holding ticket `ticket`, counting the tickets in id order from 0; ticket < total
+Process* ticketFind(TicketTree* t, long ticket) {
+    int pos = 0;
+    int step = 1;
+    while (step * 2 <= t->n) {
+        step *= 2;
+    }
+    // Descend to the last position whose prefix sum is at most ticket
+    for (; step > 0; step /= 2) {
+        if (pos + step <= t->n && t->sums[pos + step] <= ticket) {
+            pos += step;
+            ticket -= t->sums[pos];
+        }
     }
-    bool insertMid = false;
-    int insertIndex = eq->size; // default: insert at end
-    for (int i = 0; i < eq->size; i++) {
-        // primary ordering by event time
-/*        if (event->time < q->events[i]->time) {*/
-/*            insertIndex = i;*/
-/*            break;*/
-/*        }*/
-        // if times are equal and both events are READY,
-        // order by process tau then by PID
-        if ((event->process->tau < eq->events[i]->process->tau ||
-           (event->process->tau == eq->events[i]->process->tau &&
-            strcmp(event->process->pid, eq->events[i]->process->pid) < 0)) && (event->state == READY && eq->events[i]->state == READY)) 
-		{
-			insertMid = true;
-        	insertIndex = i;
-        	break;
-	   	} 
-		else if (eq->events[i]->time > event->time) {
-		    insertIndex = i;
-		    break;
-    	}
-	}
-	
-	if (insertMid) {
-    	updateProcessOrder(eq, event, insertIndex, tcs);
-    }
-
-    // Shift existing events to make room
-    for (int j = eq->size; j > insertIndex; j--) {
-        eq->events[j] = eq->events[j - 1];
-    }
-    eq->events[insertIndex] = event;
-    eq->size++;
-    return insertMid;
+    return t->procs[pos];
 }
 
-// Shortest Job First
-int SJF(Process** processes, int n, int tcs, double alpha, double lambda) {
-    // Reset all processes
-    for (int i = 0; i < n; i++) {
-        (*(processes+i))->state = ARRIVE;
-        (*(processes+i))->burstsLeft = (*(processes+i))->numBursts;
-        (*(processes+i))->tau = (int)ceil(1.0 / lambda);
-        for (int j = 0; j < (*(processes+i))->numBursts; j++){
-            (*(processes+i))->remainingBursts[j] = (*(processes+i))->cpuBursts[j];
+// Print the ready processes in id order
+void printTicketTree(FILE* out, TicketTree* t) {
+    if (t->size == 0) {
+        fprintf(out, " empty");
+        return;
+    }
+    for (int i = 0; i < t->n; i++) {
+        if (t->procs[i] != NULL) {
+            fprintf(out, " %s", pidName(t->procs[i]->info));
         }
-        // For writing to simout
-        (*(processes+i))->readyTime = 0;
-        (*(processes+i))->wait = 0;
-        (*(processes+i))->startTime = 0;
-        (*(processes+i))->turnaround = 0;
-        (*(processes+i))->cs = 0;
     }
+}
 
-    Queue q;
-    initQueue(&q, n);
-    EventQueue eq;
-    initEventQueue(&eq, n);
-    printf("time 0ms: Simulator started for SJF [Q empty]\n");
 
-    // Schedule initial arrivals
-    for (int i = 0; i < n; i++){
-        Event* newEvent = createEvent(processes[i], processes[i]->arrivalTime, ARRIVE);
-        insertEventSJF(&eq, newEvent, tcs);
-    }
-	
-    int time = 0;
-    int terminatedCount = 0;
-    int cpuFreeAt = 0;
-    int cpuIdle = -1;
-
-    while (terminatedCount < n) {
-    	// Handle Events
-        Event* e = popEvent(&eq);
-        time = e->time;
+//----------------------------------------------------------------------------------------------------------------------------
+// Latency statistics
+// Every completed CPU burst adds its wait and turnaround time to constant-memory distributions,
+// so tail percentiles come out of a run without keeping the samples.
 
-        if (e->state == ARRIVE) {
-            // Add process to the ready queue using SJF ordering
-            // bool insertMid = 
-            enqueueSJF(&q, e->process);
+// Running mean and variance (Welford)
+typedef struct {
+    long count;
+    double mean;
+    double m2;
+} RunningStat;
 
-            // Print
-            if (time <= 10000){
-                printf("time %dms: Process %s (tau %dms) arrived; added to ready queue [Q", time, e->process->pid, e->process->tau);
-                printQueue(&q);
-                printf("]\n");
-            }
+void addSample(RunningStat* s, double x) {
+    s->count++;
+    double delta = x - s->mean;
+    s->mean += delta / s->count;
+    s->m2 += delta * (x - s->mean);
+}
 
-            if (cpuIdle == -1 && time >= cpuFreeAt) {
-                Event* newEvent = createEvent(e->process, time + tcs/2, READY);
-                insertEventSJF(&eq, newEvent, tcs);
-                cpuFreeAt = time + e->process->cpuBursts[e->process->numBursts - e->process->burstsLeft] + tcs/2;
-                dequeue(&q);
+// Combine two running statistics (Chan et al.)
+void mergeStat(RunningStat* into, const RunningStat* s) {
+    if (s->count == 0) return;
+    long count = into->count + s->count;
+    double delta = s->mean - into->mean;
+    into->mean += delta * s->count / count;
+    into->m2 += s->m2 + delta * delta * ((double)into->count * s->count / count);
+    into->count = count;
+}
 
-            } else {
-                Event* newEvent = createEvent(e->process, cpuFreeAt + tcs, READY);
-                insertEventSJF(&eq, newEvent, tcs);
-                cpuFreeAt += e->process->cpuBursts[e->process->numBursts - e->process->burstsLeft] + tcs;
-            }
-        }
+double statStddev(const RunningStat* s) {
+    if (s->count < 2) return 0.0;
+    return sqrt(s->m2 / (s->count - 1));
+}
 
-        else if (e->state == READY) {
-            cpuIdle = 0;
-            if (q.size > 0 && strcmp(e->process->pid, q.procs[0]->pid) == 0) {
-                dequeue(&q);
-            }
-            int burstTime = *(e->process->cpuBursts + (e->process->numBursts - e->process->burstsLeft));
+// Log-linear histogram of non-negative ints: values below HIST_SUB are exact, larger ones fall into
+// HIST_SUB buckets per power of two, so any percentile is within 1/HIST_SUB of the recorded value
+#define HIST_SUB_BITS 6
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS ((32 - HIST_SUB_BITS) * HIST_SUB)
 
-            // Print
-            if (time <= 10000){
-                printf("time %dms: Process %s (tau %dms) started using the CPU for %dms burst [Q", 
-                    time, e->process->pid, e->process->tau, burstTime);
-                printQueue(&q);
-                printf("]\n");
-            }
-            e->process->burstsLeft--;
+typedef struct {
+    long counts[HIST_BUCKETS];
+    long total;
+    int min;
+    int max;
+} Histogram;
 
-            if (e->process->burstsLeft == 0) {
-                Event* endCpu = createEvent(e->process, time + burstTime, TERMINATED);
-                insertEventSJF(&eq, endCpu, tcs);
-            } else {
-                Event* endCpu = createEvent(e->process, time + burstTime, RUNNING);
-                insertEventSJF(&eq, endCpu, tcs);
-            }
-            if (cpuFreeAt < time + burstTime) {
-                cpuFreeAt = time + burstTime;
-            }
-        }
+int histBucket(int value) {
+    if (value < HIST_SUB) {
+        return value;
+    }
+    int shift = 31 - __builtin_clz(value) - HIST_SUB_BITS;
+    return (shift + 1) * HIST_SUB + (value >> shift) - HIST_SUB;
+}
 
-        else if (e->state == RUNNING) {
-            cpuIdle = -1;
-            // Print
-            if (time <= 10000){
-                if (e->process->burstsLeft == 1){
-                    printf("time %dms: Process %s (tau %dms) completed a CPU burst; %d burst to go [Q", 
-                        time, e->process->pid, e->process->tau, e->process->burstsLeft);
-                } else {
-                    printf("time %dms: Process %s (tau %dms) completed a CPU burst; %d bursts to go [Q", 
-                        time, e->process->pid, e->process->tau, e->process->burstsLeft);
-                }
-                printQueue(&q);
-                printf("]\n");
-            }
+// Largest value that falls into the bucket
+int histBucketMax(int bucket) {
+    if (bucket < HIST_SUB) {
+        return bucket;
+    }
+    int shift = bucket / HIST_SUB - 1;
+    long top = ((long)(bucket % HIST_SUB + HIST_SUB + 1) << shift) - 1;
+    return top > INT_MAX ? INT_MAX : (int)top;
+}
 
-            // Recalculate tau after the CPU burst
-            int oldTau = e->process->tau;
-            int completedBurst = e->process->cpuBursts[e->process->numBursts - e->process->burstsLeft - 1];
-            int newTau = (int)ceil(alpha * completedBurst + (1 - alpha) * oldTau);
+void histRecord(Histogram* h, int value) {
+    if (value < 0) value = 0;
+    if (h->total == 0 || value < h->min) h->min = value;
+    if (h->total == 0 || value > h->max) h->max = value;
+    h->counts[histBucket(value)]++;
+    h->total++;
+}
 
-            // Print
-            if (time <= 10000){
-                printf("time %dms: Recalculated tau for process %s: old tau %dms ==> new tau %dms [Q", 
-                    time, e->process->pid, oldTau, newTau);
-                e->process->tau = newTau;
-                printQueue(&q);
-                printf("]\n");
-            }
+void histMerge(Histogram* into, const Histogram* h) {
+    if (h->total == 0) return;
+    if (into->total == 0 || h->min < into->min) into->min = h->min;
+    if (into->total == 0 || h->max > into->max) into->max = h->max;
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        into->counts[b] += h->counts[b];
+    }
+    into->total += h->total;
+}
 
-			// IO Burst start
-            int ioCompTime = time + e->process->ioBursts[e->process->numBursts - e->process->burstsLeft - 1] + tcs/2;
+// Smallest recorded value with at least a fraction q of the samples at or below it
+int histPercentile(const Histogram* h, double q) {
+    if (h->total == 0) return 0;
+    long rank = (long)ceil(q * h->total);
+    if (rank < 1) rank = 1;
+    long seen = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        seen += h->counts[b];
+        if (seen >= rank) {
+            int value = histBucketMax(b);
+            if (value > h->max) value = h->max;
+            if (value < h->min) value = h->min;
+            return value;
+        }
+    }
+    return h->max;
+}
 
-            // Print
-            if (time <= 10000){
-                printf("time %dms: Process %s switching out of CPU; blocking on I/O until time %dms [Q", 
-                    time, e->process->pid, ioCompTime);
-                printQueue(&q);
-                printf("]\n");
-            }
+typedef struct {
+    RunningStat stat;
+    Histogram hist;
+} Distribution;
 
-            Event* ioBurst = createEvent(e->process, ioCompTime, WAITING);
-            insertEventSJF(&eq, ioBurst, tcs);
-        }
+void addToDistribution(Distribution* d, int value) {
+    addSample(&d->stat, value);
+    histRecord(&d->hist, value);
+}
 
-        else if (e->state == WAITING) {
-            if (cpuIdle == -1) {
-                dequeue(&q);
-            }
-            enqueueSJF(&q, e->process);
+void mergeDistribution(Distribution* into, const Distribution* d) {
+    mergeStat(&into->stat, &d->stat);
+    histMerge(&into->hist, &d->hist);
+}
 
-            // Print
-            if (time <= 10000){
-                printf("time %dms: Process %s (tau %dms) completed I/O; added to ready queue [Q", 
-                    time, e->process->pid, e->process->tau);
-                printQueue(&q);
-                printf("]\n");
-            }
-
-            if (q.size == 1 && cpuIdle == -1) {
-            	//printf("hellotest");
-                cpuFreeAt = time;
-                Event* cpuBurst = createEvent(e->process, cpuFreeAt + tcs/2, READY);
-                insertEventSJF(&eq, cpuBurst, tcs);
-            } else if (q.size > 1) {
-
-            /*
-			beginEvent Queue: [Time: 10994, Process: A0, State: RUNNING][Time: 10998, Process: A2, State: READY]
-			time 9200ms: Process A1 (tau 227ms) completed I/O; added to ready queue [Q A1 A2]
-			Event Queue: [Time: 10994, Process: A0, State: RUNNING][Time: 11184, Process: A1, State: READY][Time: 10998, Process: A2, State: READY]
-			TODO: 
-			when inserting A1 (tau 227ms) into the event queue with state READY (event queue current has A2 (tau 556ms) with state READY at the end), how do we recalculate the system elapsed time such that A2 comes later than A1
-if tau value of the furthest along READY process in event queue is greater than the tau value of the READY process currently being added to the event queue,   
-			*/
-
-                int lastProcBurst = time;
-                int i;
-
-                for (i = eq.size - 1; i >= 0; i--) {
-                    if (eq.events[i]->state == READY) {
-                    	// TEST THIS WITH OTHER TESTCASES
-                        //lastProcBurst = eq.events[i]->time + eq.events[i]->process->cpuBursts[eq.events[i]->process->numBursts - eq.events[i]->process->burstsLeft];
-                        //lastProcBurst = cpuFreeAt + eq.events[i]->process->cpuBursts[eq.events[i]->process->numBursts - eq.events[i]->process->burstsLeft];
-/*                        if (insertMid) {*/
-/*                        	lastProcBurst = cpuFreeAt;*/
-/*                        }*/
-						lastProcBurst = cpuFreeAt;
-                        break;
-                    } 
-                }
+// Per-burst wait and turnaround of one simulation, [0] for CPU-bound and [1] for I/O-bound processes
+typedef struct {
+    int ncpu;                   // Processes with a lower id are CPU-bound
+    Distribution wait[2];
+    Distribution turnaround[2];
+    Distribution lateness[2];   // Bursts with a deadline only; bursts that met it count as 0 in the percentiles
+} LatencyStats;
 
-                Event* cpuBurst = createEvent(e->process, lastProcBurst + tcs, READY);
-                // printf("lastProcBurst %d and tcs %d\n",lastProcBurst,tcs);
-                int burstTime = e->process->cpuBursts[e->process->numBursts - e->process->burstsLeft];
-                cpuFreeAt = lastProcBurst + burstTime + tcs;
+// Record a completed burst; its wait is what the process accumulated since its previous burst
+void recordBurst(LatencyStats* s, Process* p, int turnaround) {
+    int wait = p->wait - p->waitMark;
+    p->waitMark = p->wait;
+    if (s == NULL) return;
+    int cls = p->info->id < s->ncpu ? 0 : 1;
+    addToDistribution(&s->wait[cls], wait);
+    addToDistribution(&s->turnaround[cls], turnaround);
+}
 
-                if (insertEventSJF(&eq, cpuBurst, tcs)) {
-					burstTime = eq.events[i+1]->process->cpuBursts[eq.events[i+1]->process->numBursts - eq.events[i+1]->process->burstsLeft];
-					//printf("cpuFreeAt: %d\n",cpuFreeAt);
-					//printf("burstTime: %d\n",burstTime);
-                	cpuFreeAt += burstTime + tcs;
+// Record whether burst idx of p met its deadline; response is the time from the burst becoming ready to its completion
+void recordDeadline(LatencyStats* s, Process* p, int idx, int response) {
+    int deadline = p->info->deadlines != NULL ? p->info->deadlines[idx] : 0;
+    if (deadline <= 0) return;
+    p->deadlineBursts++;
+    if (response > deadline) {
+        p->deadlineMisses++;
+    }
+    if (s == NULL) return;
+    addToDistribution(&s->lateness[p->info->id < s->ncpu ? 0 : 1], response - deadline);
+}
 
-                }
-            } else {
-            	//printf("[hellotest2222]");
-                Event* cpuBurst = createEvent(e->process, cpuFreeAt + tcs, READY);
-                insertEventSJF(&eq, cpuBurst, tcs);
-            }
-        }
+// drand48 stream with its own state, so workloads can be generated on several threads and lotteries drawn per run
+// Seeded like srand48, so a seed produces the same workload as drand48 would
+typedef struct {
+    unsigned short xsubi[3];
+} Rng;
 
-        else if (e->state == TERMINATED) {
-            cpuIdle = -1;
-            printf("time %dms: Process %s terminated [Q", time, e->process->pid);
-            printQueue(&q);
-            printf("]\n");
-            terminatedCount++;
-        }
+void seedRng(Rng* rng, long seed){
+    rng->xsubi[0] = 0x330E;
+    rng->xsubi[1] = (unsigned short)(seed & 0xFFFF);
+    rng->xsubi[2] = (unsigned short)((seed >> 16) & 0xFFFF);
+}
 
-        // DEBUGGING - GET RID OF LATER =============================================================================
-        //printf("current process: %s and [Q", e->process->pid);
-		//printQueue(&q);
-        //printf("]\n");
-        //printf("[end]");
-        //printf("[current cpuFreeAt value: %d]", cpuFreeAt);
-        //printEventQueue(&eq);
-        // DEBUGGING END - GET RID OF LATER =========================================================================
-        free(e);
-    }
-    time += tcs/2;
-    printf("time %dms: Simulator ended for SJF [Q empty]\n\n", time);
-    free(q.procs);
-    return time;
+double nextRandom(Rng* rng){
+    return erand48(rng->xsubi);
 }
+
 //----------------------------------------------------------------------------------------------------------------------------
+// Single CPU engine
+// One event loop runs every algorithm; a Policy supplies the ready queue and the scheduling decisions.
+// simulate is always inlined into the per-algorithm wrappers below with a constant Policy, so the compiler
+// resolves the hooks to direct (mostly inlined) calls and there is no indirect call per event.
 
-int SRT(Process** processes, int n, int tcs, double alpha, double lambda){
-    // Reset all processes
-    for (int i = 0; i < n; i++) {
-        (*(processes+i))->state = ARRIVE;
-        (*(processes+i))->burstsLeft = (*(processes+i))->numBursts;
-        (*(processes+i))->tau = (int)ceil(1.0 / lambda);
-        for (int j = 0; j < (*(processes+i))->numBursts; j++){
-            (*(processes+i))->remainingBursts[j] = (*(processes+i))->cpuBursts[j];
-        }
-        // For writing to simout
-        (*(processes+i))->readyTime = 0;
-        (*(processes+i))->wait = 0;
-        (*(processes+i))->startTime = 0;
-        (*(processes+i))->turnaround = 0;
-        (*(processes+i))->cs = 0;
-    }
+#define MLFQ_MAX_LEVELS 64     // Non-empty levels are tracked in one 64-bit mask
 
-    Queue q;
-    initQueue(&q, n);
-    EventQueue eq;
-    initEventQueue(&eq, n);
-    printf("time 0ms: Simulator started for SRT [Q empty]\n");
+// MLFQ parameters, levels == 0 derives them from the time slice
+typedef struct {
+    int levels;
+    int quanta[MLFQ_MAX_LEVELS];    // Time slice of each level, highest priority first
+    int boost;                      // Period of the priority boost in ms, 0 never boosts
+} MlfqConfig;
 
-    // Schedule initial arrivals
-    for (int i = 0; i < n; i++){
-        Event* newEvent = createEvent(processes[i], processes[i]->arrivalTime, ARRIVE);
-        insertEventSJF(&eq, newEvent, tcs);
+// Ready queue state of the single CPU engine; each policy uses the structures it needs
+typedef struct {
+    Queue fifo;         // FCFS/RR
+    ReadyHeap heap;     // SJF/SRT
+    VruntimeTree tree;  // CFS/stride
+    Queue* levels;      // MLFQ, one FIFO per level
+    TicketTree lottery; // Lottery
+    int tslice;         // RR/stride/lottery time slice, CFS target latency
+    double alpha;       // Weight of the last burst in the tau estimate
+    int now;            // Time of the event being handled
+    // CFS and stride
+    int minGranularity;         // Shortest slice a process is given
+    long long minVruntime;      // Never decreases; waking processes are placed relative to it
+    // Stride and lottery
+    long readyTickets[2];       // Tickets of the ready processes of each class
+    Rng rng;
+    // MLFQ
+    const MlfqConfig* mlfq;
+    uint64_t levelMask;         // Bit l is set while level l is not empty
+    int nextBoost;              // Time of the next priority boost
+    int boostEpoch;             // Bumped by every boost, so levels of older epochs read as 0
+} Scheduler;
+
+typedef struct {
+    const char* name;
+    bool showTau;                                           // Log lines show the tau of the process
+    void (*init)(Scheduler* s, int n);
+    void (*free)(Scheduler* s);
+    // Add a process to the ready queue: arrival, I/O completion or after a preemption
+    void (*onArrival)(Scheduler* s, Process* p);
+    // Remove the next process to run from the ready queue, NULL if it is empty
+    Process* (*selectNext)(Scheduler* s);
+    // Optional: the process that should take the CPU from running, which has `left` ms of its
+    // predicted burst left, or NULL to keep running it
+    Process* (*shouldPreempt)(Scheduler* s, const Process* running, int left);
+    // Optional: time slice for the burst of p, 0 runs bursts to completion
+    int (*quantum)(Scheduler* s, const Process* p);
+    // Optional: whether p loses the CPU when its time slice expires, keepReason is logged when it does not
+    bool (*onQuantumExpiry)(Scheduler* s, Process* p);
+    const char* keepReason;
+    // Optional: charge p for `ran` ms on the CPU, called whenever it stops running
+    void (*onRun)(Scheduler* s, Process* p, int ran);
+    // Optional: update the estimates of p after it completed a burst of `burst` ms
+    void (*onBurstEnd)(Scheduler* s, Process* p, int burst);
+    void (*printReady)(FILE* out, Scheduler* s);
+} Policy;
+
+// Print "time Xms: Process P" with the process's tau when the policy uses it
+static inline void printProcess(const Policy* policy, FILE* out, int time, const Process* p) {
+    if (policy->showTau) {
+        fprintf(out, "time %dms: Process %s (tau %dms)", time, pidName(p->info), p->tau);
+    } else {
+        fprintf(out, "time %dms: Process %s", time, pidName(p->info));
     }
-	
-    int time = 0;
-    // int terminatedCount = 0;
-    // int cpuFreeAt = 0;
-    // int cpuIdle = -1;
+}
 
-    time += tcs/2;
-    printf("time %dms: Simulator ended for SRT [Q empty]\n\n", time);
-    freeEventQueue(&eq);
-    free(q.procs);
-    return time;
+// Print the ready queue and end the log line
+static inline void printReadyLine(const Policy* policy, FILE* out, Scheduler* s) {
+    fprintf(out, " [Q");
+    policy->printReady(out, s);
+    fprintf(out, "]\n");
 }
 
-// Round Robin
-int RR(Process** processes, int n, int tcs, int tslice){
+// Run one algorithm on a single CPU with the parameters set in s, returns the time the simulation ended
+static inline __attribute__((always_inline))
+int simulate(const Policy* policy, Scheduler s, Process** processes, int n, int tcs, double lambda, FILE* out, LatencyStats* latency) {
     // Reset all processes
     for (int i = 0; i < n; i++) {
         (*(processes+i))->state = ARRIVE;
-        (*(processes+i))->burstsLeft = (*(processes+i))->numBursts;
-        for (int j = 0; j < (*(processes+i))->numBursts; j++){
-            (*(processes+i))->remainingBursts[j] = (*(processes+i))->cpuBursts[j];
+        (*(processes+i))->burstsLeft = (*(processes+i))->info->numBursts;
+        (*(processes+i))->tau = (int)ceil(1.0 / lambda);
+        for (int j = 0; j < (*(processes+i))->info->numBursts; j++){
+            (*(processes+i))->remainingBursts[j] = (*(processes+i))->info->cpuBursts[j];
         }
         // For writing to simout
         (*(processes+i))->readyTime = 0;
         (*(processes+i))->wait = 0;
+        (*(processes+i))->waitMark = 0;
         (*(processes+i))->startTime = 0;
         (*(processes+i))->turnaround = 0;
         (*(processes+i))->cs = 0;
         (*(processes+i))->preemptions = 0;
         (*(processes+i))->oneTS = 0;
+        (*(processes+i))->vruntime = 0;
+        (*(processes+i))->level = 0;
+        (*(processes+i))->levelEpoch = 0;
+        (*(processes+i))->contendedTime = 0;
+        (*(processes+i))->entitledTime[0] = 0;
+        (*(processes+i))->entitledTime[1] = 0;
+        (*(processes+i))->deadlineBursts = 0;
+        (*(processes+i))->deadlineMisses = 0;
     }
 
-
-    // Start Simultaion
-    Queue q;
-    initQueue(&q, n);
+    policy->init(&s, n);
     EventQueue eq;
-    initEventQueue(&eq, 4*n);
-    printf("time 0ms: Simulator started for RR [Q empty]\n");
+    initEventQueue(&eq, n);
+    if (LOGGING(out)){
+        fprintf(out, "time 0ms: Simulator started for %s [Q empty]\n", policy->name);
+    }
 
-    // Arrivals
+    // Schedule initial arrivals
     for (int i = 0; i < n; i++){
-        Event* newEvent = createEvent(*(processes+i), (*(processes+i))->arrivalTime, ARRIVE);
-        insertEventFCFS(&eq, newEvent);
+        Event* newEvent = createEvent(&eq, processes[i], processes[i]->info->arrivalTime, ARRIVE);
+        insertEvent(&eq, newEvent);
     }
 
-    // Start Simulation
     int time = 0;
     int terminatedCount = 0;
-    int cpuFreeAt = 0;
-    int cpuIdle = -1;
+    int cpuFreeAt = 0;          // Time the previous process finishes switching out
+    Process* current = NULL;    // Process switching in or running, NULL when the CPU is free or switching out
+    bool started = false;       // current has started running its burst
+    int burstStart = 0;         // Time current started or resumed its burst
+    int generation = 0;         // Bumped on preemption so the burst events of the preempted process are ignored
+
     while (terminatedCount < n) {
         // Handle Events
         Event* e = popEvent(&eq);
+        STAT_ADD(eventsByState[e->state], 1);
         time = e->time;
+        s.now = time;
+        Process* p = e->process;
+        int idx = p->info->numBursts - p->burstsLeft;
 
-        // Arrival
-        if (e->state == ARRIVE){
-            // Print and add to queue
-            enqueue(&q, e->process, time);
+        // Burst events of a preempted process
+        if ((e->state == RUNNING || e->state == PREEMPTION) && e->generation != generation) {
+            releaseEvent(&eq, e);
+            continue;
+        }
 
-            // Print
-            if (time <= 10000){
-                printf("time %dms: Process %s arrived; added to ready queue [Q", time, e->process->pid);
-                printQueue(&q);
-                printf("]\n");
-            }
-            
-            // CPU is free
-            int burstTime = e->process->remainingBursts[e->process->numBursts - e->process->burstsLeft];
-            if (cpuIdle == -1 && time >= cpuFreeAt){
-                Event* newEvent = createEvent(e->process, time + tcs/2, READY);
-                insertEventFCFS(&eq, newEvent);
-                if (tslice >= burstTime){
-                    cpuFreeAt = time + burstTime + tcs/2;
-                } 
-                // Burst finishes after time slice
-                else{
-                    cpuFreeAt = time + tslice + tcs/2;
-                }
-                dequeue(&q);
-            }
-            // CPU is not free
-            else {
-                Event* newEvent = createEvent(e->process, cpuFreeAt + tcs, READY);
-                insertEventFCFS(&eq, newEvent);
-                if (tslice >= burstTime){
-                    cpuFreeAt += burstTime + tcs;
-                } 
-                // Burst finishes before timeslice
-                else {
-                    cpuFreeAt += tslice + tcs;
+        bool preempt = false;
+        if (e->state == ARRIVE || e->state == WAITING) {
+            // For writing to simout
+            p->startTime = time;    // Turnaround time
+            p->readyTime = time;    // Wait time
+            policy->onArrival(&s, p);
+
+            // The newcomer may take the CPU from the running process
+            if (policy->shouldPreempt != NULL && current != NULL && started) {
+                int left = predictedRemaining(current) - (time - burstStart);
+                preempt = policy->shouldPreempt(&s, current, left) != NULL;
+                if (preempt && TRACING(out, time)){
+                    printProcess(policy, out, time, p);
+                    fprintf(out, " %s; preempting %s", e->state == ARRIVE ? "arrived" : "completed I/O", pidName(current->info));
+                    if (policy->showTau) {
+                        fprintf(out, " (predicted remaining time %dms)", left);
+                    }
+                    printReadyLine(policy, out, &s);
                 }
             }
-
-            // For writing to simout
-            e->process->readyTime = time;           // Wait time
-        }
-        // Start CPU Burst
-        else if (e->state == READY){
-            e->process->cs++;                                           // Context Switch
-            e->process->wait += time - e->process->readyTime - tcs/2;   // Wait time
-            
-            cpuIdle = 0;
-            if (e->process->pid == q.procs[0]->pid){
-                dequeue(&q);
+            if (!preempt && TRACING(out, time)){
+                printProcess(policy, out, time, p);
+                fprintf(out, " %s; added to ready queue", e->state == ARRIVE ? "arrived" : "completed I/O");
+                printReadyLine(policy, out, &s);
             }
-
-            int burstTime = *(e->process->remainingBursts + (e->process->numBursts - e->process->burstsLeft));
-            int fullBurst = *(e->process->cpuBursts + (e->process->numBursts - e->process->burstsLeft));
+        }
+        // Preempted process finished switching out
+        else if (e->state == ENQUEUE) {
+            p->readyTime = time;    // Wait time
+            policy->onArrival(&s, p);
+        }
+        // Start or resume a CPU burst
+        else if (e->state == READY) {
+            p->cs++;                                    // Context Switch
+            p->wait += time - p->readyTime - tcs/2;     // Wait time
+            int remaining = p->remainingBursts[idx];
+            int fullBurst = p->info->cpuBursts[idx];
+            started = true;
+            burstStart = time;
 
             // Print
-            if (time <= 10000){
-                if (burstTime != fullBurst){
-                    printf("time %dms: Process %s started using the CPU for remaining %dms of %dms burst [Q", time, e->process->pid, burstTime, fullBurst);
-                    printQueue(&q);
-                    printf("]\n");
+            if (TRACING(out, time)){
+                printProcess(policy, out, time, p);
+                if (remaining != fullBurst){
+                    fprintf(out, " started using the CPU for remaining %dms of %dms burst", remaining, fullBurst);
                 } else {
-                    printf("time %dms: Process %s started using the CPU for %dms burst [Q", time, e->process->pid, fullBurst);
-                    printQueue(&q);
-                    printf("]\n");
+                    fprintf(out, " started using the CPU for %dms burst", fullBurst);
                 }
+                printReadyLine(policy, out, &s);
             }
 
-            // Update bursts
-            int *burstRem = e->process->remainingBursts + (e->process->numBursts - e->process->burstsLeft);
-            *burstRem -= tslice;
-
-            // Burst finishes its remaining time
-            if (*burstRem <= 0 || e->process->burstsLeft == 0){
-                if (e->process->burstsLeft == 0){
-                    Event* endCpu = createEvent(e->process, time + burstTime, TERMINATED);
-                    insertEventFCFS(&eq, endCpu);
-                } else{
-                    Event* endCpu = createEvent(e->process, time + burstTime, RUNNING);
-                    insertEventFCFS(&eq, endCpu);
+            // A process that became ready while this one was switching in may preempt it right away
+            Process* next = NULL;
+            if (policy->shouldPreempt != NULL) {
+                next = policy->shouldPreempt(&s, p, predictedRemaining(p));
+            }
+            if (next != NULL) {
+                if (TRACING(out, time)){
+                    printProcess(policy, out, time, next);
+                    fprintf(out, " will preempt %s", pidName(p->info));
+                    printReadyLine(policy, out, &s);
                 }
-            } 
-            // Burst is not fully complete
-            else {
-                Event* endCpu = createEvent(e->process, time + tslice, PREEMPTION);
-                insertEventFCFS(&eq, endCpu);
+                preempt = true;
+            } else {
+                int slice = policy->quantum != NULL ? policy->quantum(&s, p) : 0;
+                Event* endCpu;
+                if (slice > 0 && remaining > slice) {
+                    endCpu = createEvent(&eq, p, time + slice, PREEMPTION);
+                } else {
+                    endCpu = createEvent(&eq, p, time + remaining, RUNNING);
+                }
+                endCpu->generation = generation;
+                insertEvent(&eq, endCpu);
             }
-
-            // For writing to simout
-            if (fullBurst <= tslice){
-                e->process->oneTS++;
+        }
+        // Time slice expired, only time sliced policies schedule these
+        else if (policy->quantum != NULL && e->state == PREEMPTION) {
+            p->remainingBursts[idx] -= time - burstStart;
+            if (policy->onRun != NULL) {
+                policy->onRun(&s, p, time - burstStart);
             }
-        } 
-        // Preemption
-        else if (e->state == PREEMPTION) {
-            // No preemption
-            int *burstRem = e->process->remainingBursts + (e->process->numBursts - e->process->burstsLeft);
-            if (q.size == 0){
-                // Print
-                if (time <= 10000){
-                    printf("time %dms: Time slice expired; no preemption because ready queue is empty [Q", time);
-                    printQueue(&q);
-                    printf("]\n"); 
-                }
+            burstStart = time;
+            int remaining = p->remainingBursts[idx];
 
-                // Last time slice before finishing
-                if (*burstRem <= tslice){
-                    Event* continueBurst = createEvent(e->process, time + *burstRem, RUNNING);
-                    insertEventFCFS(&eq, continueBurst);
-                    cpuFreeAt += *burstRem;
-                } 
-                // Still more cpu bursts
-                else {
-                    *burstRem -= tslice;
-                    Event* continueBurst = createEvent(e->process, time + tslice, PREEMPTION);
-                    insertEventFCFS(&eq, continueBurst);
-                    cpuFreeAt += tslice;
+            if (policy->onQuantumExpiry(&s, p)) {
+                if (TRACING(out, time)){
+                    fprintf(out, "time %dms: Time slice expired; preempting process %s with %dms remaining", time, pidName(p->info), remaining);
+                    printReadyLine(policy, out, &s);
                 }
+                preempt = true;
             } else {
-                // Print
-                if (time <= 10000){
-                    printf("time %dms: Time slice expired; preempting process %s with %dms remaining [Q", time, e->process->pid, *burstRem);
-                    printQueue(&q);
-                    printf("]\n");
+                if (TRACING(out, time)){
+                    fprintf(out, "time %dms: Time slice expired; no preemption because %s", time, policy->keepReason);
+                    printReadyLine(policy, out, &s);
                 }
-                Event* enqueue = createEvent(e->process, time + tcs/2, ENQUEUE);
-                insertEventFCFS(&eq, enqueue);
-
-                // For writing to simout
-                e->process->preemptions++;              // Preemptions
+                int slice = policy->quantum(&s, p);
+                Event* endCpu;
+                if (remaining > slice) {
+                    endCpu = createEvent(&eq, p, time + slice, PREEMPTION);
+                } else {
+                    endCpu = createEvent(&eq, p, time + remaining, RUNNING);
+                }
+                endCpu->generation = generation;
+                insertEvent(&eq, endCpu);
             }
-        } 
-        // Add to queue after process is preempted
-        else if (e->state == ENQUEUE){
-            // For writing to simout
-            e->process->readyTime = time;   // Wait time
-
-            enqueue(&q, e->process, time);
-            // Creates an event while considering CPU Bursts times in the queue
-            Event* cpuBurst = createEvent(e->process, cpuFreeAt + tcs, READY);
-            insertEventFCFS(&eq, cpuBurst);
-            // Get the burst time of the last process ready to run
-            int lastProcBurst = getTimeOfLastEvent(&eq, time, tslice);
-            cpuFreeAt = lastProcBurst;
-        }
-        // CPU Burst complete
-        else if(e->state == RUNNING){
-            // CPU Burst complete
-            cpuIdle = -1;
-            e->process->burstsLeft--;
-            if (e->process->burstsLeft == 0){
-                Event* termination = createEvent(e->process, time, TERMINATED);
-                insertEventFCFS(&eq, termination);
+        }
+        // CPU burst complete
+        else if (e->state == RUNNING) {
+            if (policy->quantum != NULL && p->info->cpuBursts[idx] <= policy->quantum(&s, p)) {
+                p->oneTS++;
+            }
+            if (policy->onRun != NULL) {
+                policy->onRun(&s, p, time - burstStart);
+            }
+            p->remainingBursts[idx] = 0;
+            p->burstsLeft--;
+            p->turnaround += time + (tcs/2) - p->startTime;    // Turnaround time
+            recordBurst(latency, p, time + (tcs/2) - p->startTime);
+            recordDeadline(latency, p, idx, time - p->startTime);
+            current = NULL;
+            cpuFreeAt = time + tcs/2;
+
+            if (p->burstsLeft == 0) {
+                if (LOGGING(out)){
+                    fprintf(out, "time %dms: Process %s terminated", time, pidName(p->info));
+                    printReadyLine(policy, out, &s);
+                }
+                terminatedCount++;
             } else {
                 // Print
-                if (time <= 10000){
-                    if (e->process->burstsLeft == 1){
-                        printf("time %dms: Process %s completed a CPU burst; %d burst to go [Q", time, e->process->pid, e->process->burstsLeft);
-                    } else{
-                        printf("time %dms: Process %s completed a CPU burst; %d bursts to go [Q", time, e->process->pid, e->process->burstsLeft);
+                if (TRACING(out, time)){
+                    printProcess(policy, out, time, p);
+                    fprintf(out, " completed a CPU burst; %d burst%s to go", p->burstsLeft, p->burstsLeft == 1 ? "" : "s");
+                    printReadyLine(policy, out, &s);
+                }
+
+                // Update the estimates after the CPU burst
+                if (policy->onBurstEnd != NULL) {
+                    int oldTau = p->tau;
+                    policy->onBurstEnd(&s, p, p->info->cpuBursts[idx]);
+                    if (policy->showTau && TRACING(out, time)){
+                        fprintf(out, "time %dms: Recalculated tau for process %s: old tau %dms ==> new tau %dms",
+                            time, pidName(p->info), oldTau, p->tau);
+                        printReadyLine(policy, out, &s);
                     }
-                    printQueue(&q);
-                    printf("]\n");
                 }
-    
-                // IO Burst start
-                int ioCompTime = time + *(e->process->ioBursts+(e->process->numBursts - e->process->burstsLeft - 1)) + tcs/2;
 
-                // Print
-                if (time <= 10000){
-                    printf("time %dms: Process %s switching out of CPU; blocking on I/O until time %dms [Q", time, e->process->pid, ioCompTime);
-                    printQueue(&q);
-                    printf("]\n");
+                // IO Burst start
+                int ioCompTime = time + p->info->ioBursts[idx] + tcs/2;
+                if (TRACING(out, time)){
+                    fprintf(out, "time %dms: Process %s switching out of CPU; blocking on I/O until time %dms",
+                        time, pidName(p->info), ioCompTime);
+                    printReadyLine(policy, out, &s);
                 }
-                Event* ioBurst = createEvent(e->process, ioCompTime, WAITING);
-                insertEventFCFS(&eq, ioBurst);
+                Event* ioBurst = createEvent(&eq, p, ioCompTime, WAITING);
+                insertEvent(&eq, ioBurst);
             }
-        } 
-        // IO End
-        else if (e->state == WAITING){
-            // Dequeue next process if it runs before the next event 
-            if ((eq.events[0]->time - time) < (tcs/2) && eq.events[0]->state == READY){
-                dequeue(&q);
-            }
-
-            // I/O Burst complete
-            enqueue(&q, e->process, time);
+        }
 
-            // Print
-            if (time <= 10000){
-                printf("time %dms: Process %s completed I/O; added to ready queue [Q", time, e->process->pid);
-                printQueue(&q);
-                printf("]\n");
-            }
-
-            // Same process is at the head of the queue
-            if (q.size == 1 && cpuIdle == -1){
-                cpuFreeAt = time;
-                Event* cpuBurst = createEvent(e->process, cpuFreeAt + tcs/2, READY);
-                insertEventFCFS(&eq, cpuBurst);
-                cpuIdle = 0;
-                dequeue(&q);
-                int lastProcBurst = getTimeOfLastEvent(&eq, time, tslice);
-                cpuFreeAt = lastProcBurst;
-            } 
-            // Different process from the current process running
-            else {
-                Event* cpuBurst = createEvent(e->process, cpuFreeAt + tcs, READY);
-                insertEventFCFS(&eq, cpuBurst);
-                int lastProcBurst = getTimeOfLastEvent(&eq, time, tslice);
-                cpuFreeAt = lastProcBurst;
+        // Take the CPU from the running process; it rejoins the ready queue once it has switched out
+        if (preempt) {
+            int cidx = current->info->numBursts - current->burstsLeft;
+            current->remainingBursts[cidx] -= time - burstStart;
+            if (policy->onRun != NULL) {
+                policy->onRun(&s, current, time - burstStart);
             }
-
-            // For writing to simout
-            e->process->readyTime = time;          // Wait time
+            current->preemptions++;                     // Preemptions
+            Event* enqueue = createEvent(&eq, current, time + tcs/2, ENQUEUE);
+            insertEvent(&eq, enqueue);
+            generation++;
+            current = NULL;
+            cpuFreeAt = time + tcs/2;
         }
-        // Termination
-        else if (e->state == TERMINATED){
-            e->process->turnaround = time + (tcs/2) - e->process->arrivalTime; // Turnaround time
-            cpuIdle = -1;
-            e->process->burstsLeft--;
-            printf("time %dms: Process %s terminated [Q", time, e->process->pid);
-            printQueue(&q);
-            printf("]\n");
-            terminatedCount++;
+
+        // Switch the next process in once the CPU is free
+        if (current == NULL) {
+            current = policy->selectNext(&s);
+            if (current != NULL) {
+                started = false;
+                Event* cpuBurst = createEvent(&eq, current, (time > cpuFreeAt ? time : cpuFreeAt) + tcs/2, READY);
+                insertEvent(&eq, cpuBurst);
+            }
         }
-        free(e);
+        releaseEvent(&eq, e);
     }
-
     time += tcs/2;
-    printf("time %dms: Simulator ended for RR [Q empty]\n", time);
+#if LOG_LEVEL >= LOG_DEBUG
+    if (LOGGING(out)){
+        printEventPoolStats(out, &eq);
+    }
+#endif
+    if (LOGGING(out)){
+        fprintf(out, "time %dms: Simulator ended for %s [Q empty]\n\n", time, policy->name);
+    }
+    simCounters.events += eq.eventsCreated;
     freeEventQueue(&eq);
-    free(q.procs);
+    policy->free(&s);
     return time;
 }
 
+//----------------------------------------------------------------------------------------------------------------------------
+// Policies
 
-double nextExp(double lambda, double upperBound){
-    double r = drand48();
-    double x = -log(r) / lambda;
-    while (x > upperBound){
-        r = drand48();
-        x = -log(r) / lambda;
+// FIFO ready queue: FCFS and RR
+void fifoInit(Scheduler* s, int n) {
+    initQueue(&s->fifo, n);
+}
+
+void fifoFree(Scheduler* s) {
+    free(s->fifo.procs);
+}
+
+void fifoArrival(Scheduler* s, Process* p) {
+    enqueue(&s->fifo, p);
+}
+
+Process* fifoSelect(Scheduler* s) {
+    return dequeue(&s->fifo);
+}
+
+void fifoPrint(FILE* out, Scheduler* s) {
+    printQueue(out, &s->fifo);
+}
+
+// Ready heap ordered by predicted remaining time: SJF and SRT
+void heapInit(Scheduler* s, int n) {
+    initReadyHeap(&s->heap, n);
+}
+
+void heapFree(Scheduler* s) {
+    free(s->heap.procs);
+}
+
+void heapArrival(Scheduler* s, Process* p) {
+    readyHeapPush(&s->heap, p, predictedRemaining(p));
+}
+
+Process* heapSelect(Scheduler* s) {
+    return readyHeapPop(&s->heap);
+}
+
+void heapPrint(FILE* out, Scheduler* s) {
+    printReadyHeap(out, &s->heap);
+}
+
+// Exponential averaging of the burst estimate
+void recalculateTau(Scheduler* s, Process* p, int burst) {
+    p->tau = (int)ceil(s->alpha * burst + (1 - s->alpha) * p->tau);
+}
+
+// SRT: the head of the ready heap preempts if it is predicted to finish first
+Process* srtShouldPreempt(Scheduler* s, const Process* running, int left) {
+    (void)running;
+    Process* next = readyHeapPeek(&s->heap);
+    if (next != NULL && predictedRemaining(next) < left) {
+        return next;
     }
-    return x;
+    return NULL;
 }
 
-// helper for rounding to write to simout
-double ceil3(double value) {
-    return ceil(value * 1000) / 1000;
+// EDF: the ready heap is keyed by absolute deadline, bursts without one run after all that have one,
+// in the order they became ready. startTime is when the burst became ready and survives preemptions.
+#define EDF_NO_DEADLINE (LLONG_MAX / 2)
+
+long long edfDeadline(const Process* p) {
+    int idx = p->info->numBursts - p->burstsLeft;
+    int deadline = p->info->deadlines != NULL ? p->info->deadlines[idx] : 0;
+    return deadline > 0 ? (long long)p->startTime + deadline : EDF_NO_DEADLINE + p->startTime;
 }
 
-int main(int argc, char** argv){
-    if (argc < 9){
-        perror("ERROR: Invalid argument(s)");
-        return EXIT_FAILURE;
+void edfArrival(Scheduler* s, Process* p) {
+    readyHeapPush(&s->heap, p, edfDeadline(p));
+}
+
+// The head of the ready heap preempts if its deadline is earlier
+Process* edfShouldPreempt(Scheduler* s, const Process* running, int left) {
+    (void)left;
+    Process* next = readyHeapPeek(&s->heap);
+    if (next != NULL && readyBefore(next, running)) {
+        return next;
     }
+    return NULL;
+}
 
-    // Get parameters
-    int n = atoi(*(argv+1));
-    int ncpu = atoi(*(argv+2));
-    int seed = atoi(*(argv+3));
-    double lambda = atof(*(argv+4));
-    if (lambda <=0){
-        perror("ERROR: Lambda <= 0");
-        return EXIT_FAILURE;
+int rrQuantum(Scheduler* s, const Process* p) {
+    (void)p;
+    return s->tslice;
+}
+
+// RR: a process keeps the CPU for another slice when nothing else is ready
+bool rrQuantumExpiry(Scheduler* s, Process* p) {
+    (void)p;
+    return s->fifo.size > 0;
+}
+
+// CFS: the process with the least virtual runtime runs next. Virtual runtime grows by the time run scaled
+// by NICE_0_WEIGHT / weight, so heavier processes get a larger share of the CPU. The slices of the runnable
+// processes add up to the target latency (t_slice), but none is shorter than the minimum granularity.
+void cfsInit(Scheduler* s, int n) {
+    (void)n;
+    memset(&s->tree, 0, sizeof(s->tree));
+    s->minGranularity = s->tslice / CFS_GRANULARITY_DIVISOR > 1 ? s->tslice / CFS_GRANULARITY_DIVISOR : 1;
+    s->minVruntime = 0;
+}
+
+void cfsFree(Scheduler* s) {
+    (void)s;
+}
+
+// Vruntime is kept in 1/NICE_0_WEIGHT ms so small weighted deltas are not lost
+long long cfsDelta(int ran, int weight) {
+    return (long long)ran * NICE_0_WEIGHT * NICE_0_WEIGHT / weight;
+}
+
+// A process that slept may not keep an unbounded credit: it rejoins at most half a target latency
+// behind the least vruntime; a preempted process is already past it and keeps its own vruntime
+void cfsArrival(Scheduler* s, Process* p) {
+    long long floor = s->minVruntime - cfsDelta(s->tslice / 2, NICE_0_WEIGHT);
+    if (p->vruntime < floor) {
+        p->vruntime = floor;
     }
-    int upperBound = atoi(*(argv+5));
-    int tcs = atoi(*(argv+6));
-    if (tcs < 0){
-        perror("ERROR: Negative context switch");
-        return EXIT_FAILURE;
+    treeInsert(&s->tree, p);
+}
+
+Process* cfsSelect(Scheduler* s) {
+    return treePop(&s->tree);
+}
+
+// Advance the virtual time of p and the least virtual time of the runnable processes
+void chargeVruntime(Scheduler* s, Process* p, long long delta) {
+    p->vruntime += delta;
+    long long least = p->vruntime;
+    if (s->tree.leftmost != NULL && s->tree.leftmost->vruntime < least) {
+        least = s->tree.leftmost->vruntime;
     }
-    double alpha = atof(*(argv+7));
-    if (alpha > 1 || alpha < 0){
-        perror("ERROR: Alpha is not in the range 0 to 1");
-        return EXIT_FAILURE;
+    if (least > s->minVruntime) {
+        s->minVruntime = least;
     }
-    int tslice = atoi(*(argv+8));
-    if (tslice < 0){
-        perror("ERROR: Negative timeslice");
-        return EXIT_FAILURE;
+}
+
+void cfsRun(Scheduler* s, Process* p, int ran) {
+    chargeVruntime(s, p, cfsDelta(ran, p->weight));
+}
+
+// Share of the scheduling period for the running process p, which is not in the tree
+int cfsQuantum(Scheduler* s, const Process* p) {
+    int running = s->tree.size + 1;
+    long period = s->tslice;
+    if ((long)running * s->minGranularity > period) {
+        period = (long)running * s->minGranularity;
     }
-    if (ncpu == 1){
-        printf("<<< -- process set (n=%d) with %d CPU-bound process\n", n, ncpu);
-    } else {
-        printf("<<< -- process set (n=%d) with %d CPU-bound processes\n", n, ncpu);
+    long slice = period * p->weight / (s->tree.totalWeight + p->weight);
+    return slice > s->minGranularity ? (int)slice : s->minGranularity;
+}
+
+bool cfsQuantumExpiry(Scheduler* s, Process* p) {
+    return s->tree.leftmost != NULL && vruntimeBefore(s->tree.leftmost, p);
+}
+
+void cfsPrint(FILE* out, Scheduler* s) {
+    printVruntimeTree(out, &s->tree);
+}
+
+// MLFQ: a FIFO per level, the highest non-empty level runs first and a process that uses up the slice
+// of its level drops one level. Non-empty levels are kept in a bitmap, so finding the highest one is a
+// count of trailing zeros whatever the number of levels. Every boost period all processes go back to
+// the top level: the queued ones are moved there and the others are reset lazily through the epoch.
+void mlfqInit(Scheduler* s, int n) {
+    s->levels = simCalloc(s->mlfq->levels, sizeof(Queue));
+    if (s->levels == NULL) {
+        fprintf(stderr, "ERROR: Memory allocation failed for MLFQ levels\n");
+        exit(EXIT_FAILURE);
     }
-    printf("<<< -- seed=%d; lambda=%.6f; bound=%d\n\n", seed,lambda, upperBound);
+    // The top level holds every process after a boost, the others start small and grow
+    initQueue(&s->levels[0], n);
+    for (int l = 1; l < s->mlfq->levels; l++) {
+        initQueue(&s->levels[l], 4);
+    }
+    s->levelMask = 0;
+    s->nextBoost = s->mlfq->boost;
+    s->boostEpoch = 0;
+}
 
-    // Simulation Calcs
-    srand48(seed);
-    Process **processes = calloc(n, sizeof(Process*));
-    char *letters = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-    int letterCount = -1;
-    for (int i = 0; i < n; i++) {
-        // Create processes
-        *(processes+i) = calloc(1, sizeof(Process));
-        if (i % 10 == 0){
-            letterCount++;
+void mlfqFree(Scheduler* s) {
+    for (int l = 0; l < s->mlfq->levels; l++) {
+        free(s->levels[l].procs);
+    }
+    free(s->levels);
+}
+
+int mlfqLevel(const Scheduler* s, const Process* p) {
+    return p->levelEpoch == s->boostEpoch ? p->level : 0;
+}
+
+// Highest priority non-empty level, -1 when nothing is ready
+int mlfqTopLevel(const Scheduler* s) {
+    return s->levelMask != 0 ? __builtin_ctzll(s->levelMask) : -1;
+}
+
+// Boost once the period has passed; called by the hooks, so it takes effect at the next decision
+void mlfqBoost(Scheduler* s) {
+    if (s->mlfq->boost <= 0 || s->now < s->nextBoost) {
+        return;
+    }
+    Queue* top = &s->levels[0];
+    for (int l = 1; l < s->mlfq->levels; l++) {
+        Process* p;
+        while ((p = dequeue(&s->levels[l])) != NULL) {
+            enqueue(top, p);
         }
-        (*(processes+i))->pid = calloc(4, sizeof(char));
-        sprintf((*(processes + i))->pid, "%c%d", *(letters+letterCount), (i % 10));
+    }
+    s->levelMask = top->size > 0 ? 1 : 0;
+    s->boostEpoch++;
+    s->nextBoost += ((s->now - s->nextBoost) / s->mlfq->boost + 1) * s->mlfq->boost;
+}
 
-        // Get arrival times
-        double arrivalExp = nextExp(lambda, upperBound);
-        int arrivalTime = (int)floor(arrivalExp);
-        int numBursts = (int)ceil(drand48() * 32);
-        (*(processes+i))->arrivalTime = arrivalExp;
-        (*(processes+i))->endTime = INT_MAX;
-        (*(processes+i))->numBursts = numBursts;
-        (*(processes+i))->cpuBursts = calloc(numBursts + 1, sizeof(int));
-        (*(processes+i))->ioBursts = calloc(numBursts, sizeof(int));
-        // For SJF/SRT
-        (*(processes+i))->tau = (int)ceil(1.0 / lambda);
-        // For RR
-        (*(processes+i))->remainingBursts = calloc(numBursts + 1, sizeof(int));
+void mlfqArrival(Scheduler* s, Process* p) {
+    mlfqBoost(s);
+    int level = mlfqLevel(s, p);
+    p->level = level;
+    p->levelEpoch = s->boostEpoch;
+    enqueue(&s->levels[level], p);
+    s->levelMask |= 1ULL << level;
+}
 
-        // Print Process Info
-        if (i < ncpu){
-            if (numBursts == 1){
-                printf("CPU-bound process %s: arrival time %dms; %d CPU burst:\n", (*(processes+i))->pid, arrivalTime, numBursts);
+Process* mlfqSelect(Scheduler* s) {
+    mlfqBoost(s);
+    int level = mlfqTopLevel(s);
+    if (level < 0) {
+        return NULL;
+    }
+    Process* p = dequeue(&s->levels[level]);
+    if (s->levels[level].size == 0) {
+        s->levelMask &= ~(1ULL << level);
+    }
+    return p;
+}
+
+// A process ready on a higher level than the running one takes the CPU
+Process* mlfqShouldPreempt(Scheduler* s, const Process* running, int left) {
+    (void)left;
+    mlfqBoost(s);
+    int level = mlfqTopLevel(s);
+    if (level >= 0 && level < mlfqLevel(s, running)) {
+        return peekQueue(&s->levels[level]);
+    }
+    return NULL;
+}
+
+int mlfqQuantum(Scheduler* s, const Process* p) {
+    return s->mlfq->quanta[mlfqLevel(s, p)];
+}
+
+// p used up its slice: it drops a level and keeps the CPU unless a process of its new level or higher is ready
+bool mlfqQuantumExpiry(Scheduler* s, Process* p) {
+    mlfqBoost(s);
+    int level = mlfqLevel(s, p);
+    if (level + 1 < s->mlfq->levels) {
+        level++;
+    }
+    p->level = level;
+    p->levelEpoch = s->boostEpoch;
+    int top = mlfqTopLevel(s);
+    return top >= 0 && top <= level;
+}
+
+void mlfqPrint(FILE* out, Scheduler* s) {
+    if (s->levelMask == 0) {
+        fprintf(out, " empty");
+        return;
+    }
+    for (uint64_t mask = s->levelMask; mask != 0; mask &= mask - 1) {
+        int level = __builtin_ctzll(mask);
+        fprintf(out, " L%d:", level);
+        printQueue(out, &s->levels[level]);
+    }
+}
+
+// Stride: each process advances its pass by STRIDE_UNIT / tickets per ms it runs, and the lowest pass
+// runs next, so over time processes get the CPU in proportion to their tickets. Passes live in the
+// vruntime tree; a process that becomes ready again starts no lower than the least pass, so time spent
+// blocked is not saved up.
+#define STRIDE_UNIT (1 << 20)
+
+void strideArrival(Scheduler* s, Process* p) {
+    if (p->vruntime < s->minVruntime) {
+        p->vruntime = s->minVruntime;
+    }
+    treeInsert(&s->tree, p);
+    s->readyTickets[p->ticketClass] += p->tickets;
+}
+
+// Split the `ran` ms p just ran between the classes by the tickets of p and of the ready processes.
+// Time nobody else was ready for says nothing about the shares and is left out.
+void chargeShare(Scheduler* s, Process* p, int ran) {
+    long ready = s->readyTickets[0] + s->readyTickets[1];
+    if (ready == 0) {
+        return;
+    }
+    p->contendedTime += ran;
+    for (int c = 0; c < 2; c++) {
+        long tickets = s->readyTickets[c] + (p->ticketClass == c ? p->tickets : 0);
+        p->entitledTime[c] += (double)ran * tickets / (ready + p->tickets);
+    }
+}
+
+Process* strideSelect(Scheduler* s) {
+    Process* p = treePop(&s->tree);
+    if (p != NULL) {
+        s->readyTickets[p->ticketClass] -= p->tickets;
+    }
+    return p;
+}
+
+void strideRun(Scheduler* s, Process* p, int ran) {
+    chargeVruntime(s, p, (long long)ran * STRIDE_UNIT / p->tickets);
+    chargeShare(s, p, ran);
+}
+
+// Lottery: at every time slice the running and the ready processes draw a ticket, the holder runs next
+void lotteryInit(Scheduler* s, int n) {
+    initTicketTree(&s->lottery, n);
+}
+
+void lotteryFree(Scheduler* s) {
+    freeTicketTree(&s->lottery);
+}
+
+void lotteryArrival(Scheduler* s, Process* p) {
+    ticketInsert(&s->lottery, p);
+    s->readyTickets[p->ticketClass] += p->tickets;
+}
+
+Process* lotterySelect(Scheduler* s) {
+    if (s->lottery.size == 0) {
+        return NULL;
+    }
+    Process* p = ticketFind(&s->lottery, (long)(nextRandom(&s->rng) * s->lottery.total));
+    ticketRemove(&s->lottery, p);
+    s->readyTickets[p->ticketClass] -= p->tickets;
+    return p;
+}
+
+// The running process p holds tickets after those of the ready processes and keeps the CPU if it wins
+bool lotteryQuantumExpiry(Scheduler* s, Process* p) {
+    if (s->lottery.size == 0) {
+        return false;
+    }
+    long ticket = (long)(nextRandom(&s->rng) * (s->lottery.total + p->tickets));
+    return ticket < s->lottery.total;
+}
+
+void lotteryRun(Scheduler* s, Process* p, int ran) {
+    chargeShare(s, p, ran);
+}
+
+void lotteryPrint(FILE* out, Scheduler* s) {
+    printTicketTree(out, &s->lottery);
+}
+
+const Policy fcfsPolicy = {
+    .name = "FCFS", .init = fifoInit, .free = fifoFree, .onArrival = fifoArrival, .selectNext = fifoSelect,
+    .printReady = fifoPrint,
+};
+
+const Policy sjfPolicy = {
+    .name = "SJF", .showTau = true, .init = heapInit, .free = heapFree, .onArrival = heapArrival, .selectNext = heapSelect,
+    .onBurstEnd = recalculateTau, .printReady = heapPrint,
+};
+
+const Policy srtPolicy = {
+    .name = "SRT", .showTau = true, .init = heapInit, .free = heapFree, .onArrival = heapArrival, .selectNext = heapSelect,
+    .shouldPreempt = srtShouldPreempt, .onBurstEnd = recalculateTau, .printReady = heapPrint,
+};
+
+const Policy edfPolicy = {
+    .name = "EDF", .init = heapInit, .free = heapFree, .onArrival = edfArrival, .selectNext = heapSelect,
+    .shouldPreempt = edfShouldPreempt, .printReady = heapPrint,
+};
+
+const Policy rrPolicy = {
+    .name = "RR", .init = fifoInit, .free = fifoFree, .onArrival = fifoArrival, .selectNext = fifoSelect,
+    .quantum = rrQuantum, .onQuantumExpiry = rrQuantumExpiry, .keepReason = "ready queue is empty", .printReady = fifoPrint,
+};
+
+const Policy cfsPolicy = {
+    .name = "CFS", .init = cfsInit, .free = cfsFree, .onArrival = cfsArrival, .selectNext = cfsSelect,
+    .quantum = cfsQuantum, .onQuantumExpiry = cfsQuantumExpiry, .keepReason = "it still has the least vruntime",
+    .onRun = cfsRun, .printReady = cfsPrint,
+};
+
+const Policy stridePolicy = {
+    .name = "STRIDE", .init = cfsInit, .free = cfsFree, .onArrival = strideArrival, .selectNext = strideSelect,
+    .quantum = rrQuantum, .onQuantumExpiry = cfsQuantumExpiry, .keepReason = "it still has the lowest pass",
+    .onRun = strideRun, .printReady = cfsPrint,
+};
+
+const Policy lotteryPolicy = {
+    .name = "LOTTERY", .init = lotteryInit, .free = lotteryFree, .onArrival = lotteryArrival, .selectNext = lotterySelect,
+    .quantum = rrQuantum, .onQuantumExpiry = lotteryQuantumExpiry, .keepReason = "it drew the winning ticket",
+    .onRun = lotteryRun, .printReady = lotteryPrint,
+};
+
+const Policy mlfqPolicy = {
+    .name = "MLFQ", .init = mlfqInit, .free = mlfqFree, .onArrival = mlfqArrival, .selectNext = mlfqSelect,
+    .shouldPreempt = mlfqShouldPreempt, .quantum = mlfqQuantum, .onQuantumExpiry = mlfqQuantumExpiry,
+    .keepReason = "no process of the same or a higher level is ready", .printReady = mlfqPrint,
+};
+
+// First Come First Serve
+int FCFS(Process** processes, int n, int tcs, double lambda, FILE* out, LatencyStats* latency) {
+    return simulate(&fcfsPolicy, (Scheduler){0}, processes, n, tcs, lambda, out, latency);
+}
+
+// Shortest Job First
+int SJF(Process** processes, int n, int tcs, double alpha, double lambda, FILE* out, LatencyStats* latency) {
+    return simulate(&sjfPolicy, (Scheduler){.alpha = alpha}, processes, n, tcs, lambda, out, latency);
+}
+
+// Shortest Remaining Time
+int SRT(Process** processes, int n, int tcs, double alpha, double lambda, FILE* out, LatencyStats* latency) {
+    return simulate(&srtPolicy, (Scheduler){.alpha = alpha}, processes, n, tcs, lambda, out, latency);
+}
+
+// Earliest Deadline First
+int EDF(Process** processes, int n, int tcs, double lambda, FILE* out, LatencyStats* latency) {
+    return simulate(&edfPolicy, (Scheduler){0}, processes, n, tcs, lambda, out, latency);
+}
+
+// Round Robin
+int RR(Process** processes, int n, int tcs, int tslice, double lambda, FILE* out, LatencyStats* latency) {
+    return simulate(&rrPolicy, (Scheduler){.tslice = tslice}, processes, n, tcs, lambda, out, latency);
+}
+
+// Completely Fair Scheduler
+int CFS(Process** processes, int n, int tcs, int tslice, double lambda, FILE* out, LatencyStats* latency) {
+    return simulate(&cfsPolicy, (Scheduler){.tslice = tslice}, processes, n, tcs, lambda, out, latency);
+}
+
+// Stride scheduling
+int STRIDE(Process** processes, int n, int tcs, int tslice, double lambda, FILE* out, LatencyStats* latency) {
+    return simulate(&stridePolicy, (Scheduler){.tslice = tslice}, processes, n, tcs, lambda, out, latency);
+}
+
+// Lottery scheduling, the draws are seeded with seed
+int LOTTERY(Process** processes, int n, int tcs, int tslice, long seed, double lambda, FILE* out, LatencyStats* latency) {
+    Scheduler s = {.tslice = tslice};
+    seedRng(&s.rng, seed);
+    return simulate(&lotteryPolicy, s, processes, n, tcs, lambda, out, latency);
+}
+
+// Multi-level feedback queue
+int MLFQ(Process** processes, int n, int tcs, const MlfqConfig* config, double lambda, FILE* out, LatencyStats* latency) {
+    return simulate(&mlfqPolicy, (Scheduler){.mlfq = config}, processes, n, tcs, lambda, out, latency);
+}
+
+
+// Generated process set along with the burst totals written to simout
+typedef struct {
+    ProcessInfo* processes;
+    int n;
+    int ncpu;
+    int seed;
+    double lambda;
+    int upperBound;
+    // CPU bursts of CPU-bound / I/O-bound processes
+    double cpuBoundBurst;
+    double ioBoundBurst;
+    int numCpuBurst;
+    int numIoBurst;
+    // I/O bursts of CPU-bound / I/O-bound processes
+    double cpuIOBurst;
+    double ioIOBurst;
+    int numCpuIOBurst;
+    int numIoIOBurst;
+    // Every process's CPU bursts followed by its I/O bursts, back to back in process order;
+    // cpuBursts and ioBursts of each process point into it
+    int* bursts;
+    long totalBursts;
+    int* deadlines;         // Relative deadline of every CPU burst in process order, NULL when there are none
+    char* names;            // Names of imported processes, back to back; NULL for generated ones
+    // Set when the bursts point into a mapped trace file instead of the arena
+    void* mapping;
+    size_t mappingSize;
+} Workload;
+
+void freeWorkload(Workload* w){
+    free(w->processes);
+    w->processes = NULL;
+    free(w->bursts);
+    w->bursts = NULL;
+    // The deadlines and names of a mapped trace are part of the mapping
+    if (w->mapping == NULL){
+        free(w->deadlines);
+        free(w->names);
+    }
+    w->deadlines = NULL;
+    w->names = NULL;
+    if (w->mapping != NULL){
+        munmap(w->mapping, w->mappingSize);
+        w->mapping = NULL;
+    }
+}
+
+// Make room in the arena for a process with numBursts bursts, returns the offset of its CPU bursts
+long reserveBursts(Workload* w, long* capacity, int numBursts){
+    long offset = w->totalBursts;
+    if (offset + 2 * numBursts > *capacity){
+        while (offset + 2 * numBursts > *capacity){
+            *capacity = *capacity == 0 ? 1024 : *capacity * 2;
+        }
+        int* bursts = realloc(w->bursts, *capacity * sizeof(int));
+        if (bursts == NULL){
+            fprintf(stderr, "ERROR: Memory allocation failed for workload bursts\n");
+            exit(EXIT_FAILURE);
+        }
+        w->bursts = bursts;
+    }
+    w->totalBursts += 2 * numBursts;
+    return offset;
+}
+
+// Point every process at its bursts once the arena has stopped moving
+void attachBursts(Workload* w){
+    long offset = 0;
+    for (int i = 0; i < w->n; i++){
+        ProcessInfo* p = w->processes + i;
+        p->cpuBursts = w->bursts + offset;
+        p->ioBursts = w->bursts + offset + p->numBursts;
+        p->deadlines = w->deadlines != NULL ? w->deadlines + offset / 2 : NULL;
+        offset += 2 * p->numBursts;
+    }
+}
+
+double nextExp(Rng* rng, double lambda, double upperBound){
+    double r = nextRandom(rng);
+    double x = -log(r) / lambda;
+    while (x > upperBound){
+        r = nextRandom(rng);
+        x = -log(r) / lambda;
+    }
+    return x;
+}
+
+// Number the processes in workload order; their names are derived from the ids when logging
+void numberProcesses(Workload* w){
+    w->names = NULL;
+    for (int i = 0; i < w->n; i++) {
+        w->processes[i].id = i;
+        w->processes[i].name = NULL;
+    }
+}
+
+// Compute the burst totals written to simout
+void summarizeWorkload(Workload* w){
+    int n = w->n;
+    int ncpu = w->ncpu;
+    // calculate overall stats
+    w->cpuBoundBurst = 0.0;
+    w->ioBoundBurst = 0.0;
+    w->numCpuBurst = 0;
+    w->numIoBurst = 0;
+    // CPU burst calc
+    for (int i = 0; i < n; i++){
+        ProcessInfo *p = w->processes + i;
+        for (int j = 0; j < p->numBursts; j++){
+            if (i < ncpu) {
+                w->cpuBoundBurst += p->cpuBursts[j];
+                w->numCpuBurst++;
             } else {
-                printf("CPU-bound process %s: arrival time %dms; %d CPU bursts:\n", (*(processes+i))->pid, arrivalTime, numBursts);
+                w->ioBoundBurst += p->cpuBursts[j];
+                w->numIoBurst++;
             }
-        } else{
-            if (numBursts == 1){
-                printf("I/O-bound process %s: arrival time %dms; %d CPU burst:\n",(*(processes+i))->pid, arrivalTime, numBursts);
+        }
+    }
+
+    w->cpuIOBurst = 0.0;
+    w->ioIOBurst = 0.0;
+    w->numCpuIOBurst = 0;
+    w->numIoIOBurst = 0;
+    // IO Bursts calc
+    for (int i = 0; i < n; i++){
+        ProcessInfo *p = w->processes + i;
+        for (int j = 0; j < p->numBursts - 1; j++){
+            if (i < ncpu) {
+                w->cpuIOBurst += p->ioBursts[j];
+                w->numCpuIOBurst++;
             } else {
-                printf("I/O-bound process %s: arrival time %dms; %d CPU bursts:\n",(*(processes+i))->pid, arrivalTime, numBursts);
+                w->ioIOBurst += p->ioBursts[j];
+                w->numIoIOBurst++;
             }
         }
-        
+    }
+}
+
+// Generated CPU bursts must complete within their length times a slack drawn uniformly from
+// [DEADLINE_SLACK_MIN, DEADLINE_SLACK_MAX) after they become ready
+#define DEADLINE_SLACK_MIN 2.0
+#define DEADLINE_SLACK_MAX 10.0
+#define DEADLINE_SEED_SALT 0x2545F491
+
+// Generate the process set for (seed, lambda, bound), with burst deadlines if requested
+void generateWorkload(Workload* w, int n, int ncpu, int seed, double lambda, int upperBound, bool withDeadlines){
+    w->n = n;
+    w->ncpu = ncpu;
+    w->seed = seed;
+    w->lambda = lambda;
+    w->upperBound = upperBound;
+    w->bursts = NULL;
+    w->totalBursts = 0;
+    w->deadlines = NULL;
+    w->mapping = NULL;
+    w->mappingSize = 0;
+
+    Rng rng;
+    seedRng(&rng, seed);
+    w->processes = calloc(n, sizeof(ProcessInfo));
+    numberProcesses(w);
+    long capacity = 0;
+    for (int i = 0; i < n; i++) {
+        // Create processes
+        ProcessInfo *p = w->processes + i;
+
+        // Get arrival times
+        double arrivalExp = nextExp(&rng, lambda, upperBound);
+        int numBursts = (int)ceil(nextRandom(&rng) * 32);
+        p->arrivalTime = arrivalExp;
+        p->numBursts = numBursts;
+        // Valid until the next process grows the arena
+        long offset = reserveBursts(w, &capacity, numBursts);
+        p->cpuBursts = w->bursts + offset;
+        p->ioBursts = w->bursts + offset + numBursts;
+        p->ioBursts[numBursts - 1] = 0;
+
         // Simulate CPU Bursts
         for (int j = 0; j < numBursts; j++) {
-            int cpuBurst = (int)ceil(nextExp(lambda, upperBound));
+            int cpuBurst = (int)ceil(nextExp(&rng, lambda, upperBound));
             if (j < numBursts - 1) {
-                int ioBurst = (int)ceil(nextExp(lambda, upperBound));
+                int ioBurst = (int)ceil(nextExp(&rng, lambda, upperBound));
                 // Check for CPU-bound Process
                 if (i < ncpu){
                     cpuBurst *= 4;
                 } else{
                     ioBurst *= 8;
                 }
-                *((*(processes+i))->ioBursts+j) = ioBurst;
-                printf("==> CPU burst %dms ==> I/O burst %dms\n", cpuBurst, ioBurst);
+                *(p->ioBursts+j) = ioBurst;
             } else {
                 if (i < ncpu){
                     cpuBurst *= 4;
                 }
-                printf("==> CPU burst %dms\n\n", cpuBurst);
             }
-            *((*(processes+i))->cpuBursts+j) = cpuBurst;
+            *(p->cpuBursts+j) = cpuBurst;
         }
     }
 
-    printf("<<< PROJECT SIMULATIONS\n");
-    printf("<<< -- t_cs=%dms; alpha=%.2f; t_slice=%dms\n", tcs, alpha, tslice);
-
-    // Write to file
-    // Open the output file for writing.
-    FILE *fp = fopen("simout.txt", "w");
-    if (fp == NULL) {
-        perror("Error opening file");
-        return 1;
-    }
-    
-    // Write general simulation statistics
-    fprintf(fp, "-- number of processes: %d\n", n);
-    fprintf(fp, "-- number of CPU-bound processes: %d\n", ncpu);
-    fprintf(fp, "-- number of I/O-bound processes: %d\n", n-ncpu);
-    
-    // calculate overall stats
-    double cpuBoundBurst = 0.0;
-    double ioBoundBurst = 0.0;
-    int numCpuBurst = 0;
-    int numIoBurst = 0;
-    // CPU burst calc
-    for (int i = 0; i < n; i++){
-        Process *p = processes[i];
-        for (int j = 0; j < p->numBursts; j++){
-            if (i < ncpu) {
-                cpuBoundBurst += p->cpuBursts[j];
-                numCpuBurst++;
-            } else {
-                ioBoundBurst += p->cpuBursts[j];
-                numIoBurst++;
+    // Deadlines come from their own stream, so a seed produces the same bursts with or without them
+    if (withDeadlines) {
+        Rng deadlineRng;
+        seedRng(&deadlineRng, seed ^ DEADLINE_SEED_SALT);
+        w->deadlines = malloc((w->totalBursts / 2 > 0 ? w->totalBursts / 2 : 1) * sizeof(int));
+        long offset = 0;
+        for (int i = 0; i < n; i++) {
+            // CPU bursts of the process, followed in the arena by its I/O bursts
+            const int* cpuBursts = w->bursts + offset;
+            for (int j = 0; j < w->processes[i].numBursts; j++) {
+                double slack = DEADLINE_SLACK_MIN + nextRandom(&deadlineRng) * (DEADLINE_SLACK_MAX - DEADLINE_SLACK_MIN);
+                w->deadlines[offset / 2 + j] = (int)ceil(cpuBursts[j] * slack);
             }
+            offset += 2 * w->processes[i].numBursts;
         }
     }
+    attachBursts(w);
+    summarizeWorkload(w);
+}
 
-    double cpuIOBurst = 0.0;
-    double ioIOBurst = 0.0;
-    int numCpuIOBurst = 0;
-    int numIoIOBurst = 0;
-    // IO Bursts calc
-    for (int i = 0; i < n; i++){
-        Process *p = processes[i];
-        for (int j = 0; j < p->numBursts - 1; j++){
-            if (i < ncpu) {
-                cpuIOBurst += p->ioBursts[j];
-                numCpuIOBurst++;
+// Print every process and its bursts
+void printWorkload(FILE* out, const Workload* w){
+    for (int i = 0; i < w->n; i++) {
+        ProcessInfo *p = w->processes + i;
+        int numBursts = p->numBursts;
+        // Print Process Info
+        if (i < w->ncpu){
+            if (numBursts == 1){
+                fprintf(out, "CPU-bound process %s: arrival time %dms; %d CPU burst:\n", pidName(p), p->arrivalTime, numBursts);
+            } else {
+                fprintf(out, "CPU-bound process %s: arrival time %dms; %d CPU bursts:\n", pidName(p), p->arrivalTime, numBursts);
+            }
+        } else{
+            if (numBursts == 1){
+                fprintf(out, "I/O-bound process %s: arrival time %dms; %d CPU burst:\n", pidName(p), p->arrivalTime, numBursts);
+            } else {
+                fprintf(out, "I/O-bound process %s: arrival time %dms; %d CPU bursts:\n", pidName(p), p->arrivalTime, numBursts);
+            }
+        }
+        for (int j = 0; j < numBursts; j++) {
+            if (j < numBursts - 1) {
+                fprintf(out, "==> CPU burst %dms ==> I/O burst %dms\n", p->cpuBursts[j], p->ioBursts[j]);
             } else {
-                ioIOBurst += p->ioBursts[j];
-                numIoIOBurst++;
+                fprintf(out, "==> CPU burst %dms\n\n", p->cpuBursts[j]);
             }
         }
     }
+}
 
-    fprintf(fp, "-- CPU-bound average CPU burst time: %.3f ms\n", ceil3(cpuBoundBurst/numCpuBurst) );
-    fprintf(fp, "-- I/O-bound average CPU burst time: %.3f ms\n", ceil3(ioBoundBurst/numIoBurst) );
-    fprintf(fp, "-- overall average CPU burst time: %.3f ms\n",  ceil3( (cpuBoundBurst + ioBoundBurst)/(numCpuBurst+numIoBurst)) );
-    fprintf(fp, "-- CPU-bound average I/O burst time: %.3f ms\n", ceil3(cpuIOBurst/numCpuIOBurst) );
-    fprintf(fp, "-- I/O-bound average I/O burst time: %.3f ms\n", ceil3(ioIOBurst/numIoIOBurst) );
-    fprintf(fp, "-- overall average I/O burst time: %.3f ms\n\n", ceil3( (cpuIOBurst + ioIOBurst)/(numCpuIOBurst+numIoIOBurst)) );
-    
+//----------------------------------------------------------------------------------------------------------------------------
+// Binary workload traces
+// Layout: WorkloadHeader, then int32 arrival[n], int32 numBursts[n], uint64 burstOffset[n], int32 nice[n],
+// int32 cpuBursts[totalBursts], int32 ioBursts[totalBursts], int32 deadlines[totalBursts], char names[]
+// Process i's bursts start at burstOffset[i] in the burst and deadline arrays; its last I/O burst is 0
+// names runs to the end of the file: the n NUL-terminated names of an imported workload in process order,
+// or nothing for a generated one, whose names are derived from the ids
+// Version 1 traces have no nice array, their processes load with nice 0; versions before 3 have no deadlines
+// and versions before 4 no names
 
-    // FCFS
-    int fcfsTime = FCFS(processes, n, tcs);
-    // Write FCFS 
-    fprintf(fp, "Algorithm FCFS\n");
-    fprintf(fp, "-- CPU utilization: %.3f%%\n", ceil3((cpuBoundBurst + ioBoundBurst)/fcfsTime * 100));
+#define WORKLOAD_MAGIC "OSWLTRC"
+#define WORKLOAD_VERSION 4
+#define WORKLOAD_BYTE_ORDER 0x01020304u
 
-    // calc wait time
-    double cpuWait = 0.0;
-    double ioWait = 0.0;
-    for (int i = 0; i < n; i++){
-        if (i < ncpu) {
-            cpuWait+= processes[i]->wait;
-        } else {
-            ioWait += processes[i]->wait;
-        }
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;     // Written natively, rejects traces from a machine with the other endianness
+    uint32_t n;
+    uint32_t ncpu;
+    int32_t seed;
+    int32_t upperBound;
+    double lambda;
+    uint64_t totalBursts;
+} WorkloadHeader;
+
+// Write the workload to path, returns false on failure
+bool saveWorkload(const Workload* w, const char* path){
+    FILE* fp = fopen(path, "wb");
+    if (fp == NULL) {
+        perror("ERROR: fopen() failed");
+        return false;
+    }
+    WorkloadHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, WORKLOAD_MAGIC, sizeof(WORKLOAD_MAGIC));
+    header.version = WORKLOAD_VERSION;
+    header.byteOrder = WORKLOAD_BYTE_ORDER;
+    header.n = w->n;
+    header.ncpu = w->ncpu;
+    header.seed = w->seed;
+    header.upperBound = w->upperBound;
+    header.lambda = w->lambda;
+    for (int i = 0; i < w->n; i++) {
+        header.totalBursts += w->processes[i].numBursts;
     }
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
 
-    fprintf(fp, "-- CPU-bound average wait time: %.3f ms\n", ceil3(cpuWait / numCpuBurst));
-    fprintf(fp, "-- I/O-bound average wait time: %.3f ms\n", ceil3(ioWait / numIoBurst));
-    fprintf(fp, "-- overall average wait time: %.3f ms\n", ceil3( (cpuWait + ioWait) / (numCpuBurst+numIoBurst) ));
-    
-    // calc turnaround time
-    double fcfsCpuTR = 0.0;
-    double fcfsIoTR = 0.0;
-    for (int i = 0; i < n; i++){
-        if (i < ncpu) {
-            fcfsCpuTR += processes[i]->turnaround;
-        } else {
-            fcfsIoTR += processes[i]->turnaround;
+    // Per-process arrays
+    for (int i = 0; ok && i < w->n; i++) {
+        int32_t arrival = w->processes[i].arrivalTime;
+        ok = fwrite(&arrival, sizeof(arrival), 1, fp) == 1;
+    }
+    for (int i = 0; ok && i < w->n; i++) {
+        int32_t numBursts = w->processes[i].numBursts;
+        ok = fwrite(&numBursts, sizeof(numBursts), 1, fp) == 1;
+    }
+    uint64_t offset = 0;
+    for (int i = 0; ok && i < w->n; i++) {
+        ok = fwrite(&offset, sizeof(offset), 1, fp) == 1;
+        offset += w->processes[i].numBursts;
+    }
+    for (int i = 0; ok && i < w->n; i++) {
+        int32_t nice = w->processes[i].nice;
+        ok = fwrite(&nice, sizeof(nice), 1, fp) == 1;
+    }
+    // Burst arrays
+    for (int i = 0; ok && i < w->n; i++) {
+        const ProcessInfo* p = w->processes + i;
+        ok = fwrite(p->cpuBursts, sizeof(int32_t), p->numBursts, fp) == (size_t)p->numBursts;
+    }
+    for (int i = 0; ok && i < w->n; i++) {
+        const ProcessInfo* p = w->processes + i;
+        ok = fwrite(p->ioBursts, sizeof(int32_t), p->numBursts, fp) == (size_t)p->numBursts;
+    }
+    // Bursts without a deadline are written as 0
+    for (int i = 0; ok && i < w->n; i++) {
+        const ProcessInfo* p = w->processes + i;
+        for (int j = 0; ok && j < p->numBursts; j++) {
+            int32_t deadline = p->deadlines != NULL ? p->deadlines[j] : 0;
+            ok = fwrite(&deadline, sizeof(deadline), 1, fp) == 1;
         }
     }
-    fprintf(fp, "-- CPU-bound average turnaround time: %.3f ms\n", ceil3(fcfsCpuTR / numCpuBurst));
-    fprintf(fp, "-- I/O-bound average turnaround time: %.3f ms\n", ceil3(fcfsIoTR / numIoBurst));
-    fprintf(fp, "-- overall average turnaround time: %.3f ms\n", ceil3( (fcfsCpuTR + fcfsIoTR) / (numCpuBurst+numIoBurst) ));
-    
-    // calc context switches
-    int fcfsCpuCs = 0;
-    int fcfsIoCs = 0;
-    for (int i = 0; i < n; i++){
-        if (i < ncpu) {
-            fcfsCpuCs  += processes[i]->cs;
-        } else {
-            fcfsIoCs += processes[i]->cs;
-        }
-    }
-    fprintf(fp, "-- CPU-bound number of context switches: %d\n", fcfsCpuCs);
-    fprintf(fp, "-- I/O-bound number of context switches: %d\n", fcfsIoCs);
-    fprintf(fp, "-- overall number of context switches: %d\n", fcfsCpuCs + fcfsIoCs);
-    fprintf(fp, "-- CPU-bound number of preemptions: 0\n");
-    fprintf(fp, "-- I/O-bound number of preemptions: 0\n");
-    fprintf(fp, "-- overall number of preemptions: 0\n\n");
-
-    // SJF
-    // int sjfTime = SJF(processes, n, tcs, alpha, lambda);
-    // Write SJF 
-    fprintf(fp, "Algorithm SJF\n");
-    // fprintf(fp, "-- CPU utilization: %.3f%%\n", ceil3((cpuBoundBurst + ioBoundBurst)/sjfTime * 100));
-    // fprintf(fp, "-- CPU-bound average wait time: %.3f ms\n", ceil3(fcfs_cpu_bound_avg_wait));
-    // fprintf(fp, "-- I/O-bound average wait time: %.3f ms\n", ceil3(fcfs_io_bound_avg_wait));
-    // fprintf(fp, "-- overall average wait time: %.3f ms\n", ceil3(fcfs_overall_avg_wait));
-    // fprintf(fp, "-- CPU-bound average turnaround time: %.3f ms\n", ceil3(fcfs_cpu_bound_avg_turnaround));
-    // fprintf(fp, "-- I/O-bound average turnaround time: %.3f ms\n", ceil3(fcfs_io_bound_avg_turnaround));
-    // fprintf(fp, "-- overall average turnaround time: %.3f ms\n", ceil3(fcfs_overall_avg_turnaround));
-    // fprintf(fp, "-- CPU-bound number of context switches: %d\n", fcfs_cpu_bound_context_switches);
-    // fprintf(fp, "-- I/O-bound number of context switches: %d\n", fcfs_io_bound_context_switches);
-    // fprintf(fp, "-- overall number of context switches: %d\n", fcfs_overall_context_switches);
-    fprintf(fp, "-- CPU-bound number of preemptions: 0\n");
-    fprintf(fp, "-- I/O-bound number of preemptions: 0\n");
-    fprintf(fp, "-- overall number of preemptions: 0\n\n");
-
-    // SRT
-    int srtTime = SRT(processes, n, tcs, alpha, lambda);
-    // Write SRT
-    fprintf(fp, "Algorithm SRT\n");
-    fprintf(fp, "-- CPU utilization: %.3f%%\n", ceil3((cpuBoundBurst + ioBoundBurst)/srtTime * 100));
-    // fprintf(fp, "-- CPU-bound average wait time: %.3f ms\n", ceil3(fcfs_cpu_bound_avg_wait));
-    // fprintf(fp, "-- I/O-bound average wait time: %.3f ms\n", ceil3(fcfs_io_bound_avg_wait));
-    // fprintf(fp, "-- overall average wait time: %.3f ms\n", ceil3(fcfs_overall_avg_wait));
-    // fprintf(fp, "-- CPU-bound average turnaround time: %.3f ms\n", ceil3(fcfs_cpu_bound_avg_turnaround));
-    // fprintf(fp, "-- I/O-bound average turnaround time: %.3f ms\n", ceil3(fcfs_io_bound_avg_turnaround));
-    // fprintf(fp, "-- overall average turnaround time: %.3f ms\n", ceil3(fcfs_overall_avg_turnaround));
-    // fprintf(fp, "-- CPU-bound number of context switches: %d\n", fcfs_cpu_bound_context_switches);
-    // fprintf(fp, "-- I/O-bound number of context switches: %d\n", fcfs_io_bound_context_switches);
-    // fprintf(fp, "-- overall number of context switches: %d\n", fcfs_overall_context_switches);
-    fprintf(fp, "-- CPU-bound number of preemptions: 0\n");
-    fprintf(fp, "-- I/O-bound number of preemptions: 0\n");
-    fprintf(fp, "-- overall number of preemptions: 0\n\n");
-
-    // RR
-    int rrTime = RR(processes, n, tcs, tslice);
-    // Write RR
-    fprintf(fp, "Algorithm RR\n");
-    fprintf(fp, "-- CPU utilization: %.3f%%\n", ceil3((cpuBoundBurst + ioBoundBurst)/rrTime * 100));
-
-    // calc wait time
-    double rrCpuWait = 0.0;
-    double rrIoWait = 0.0;
-    for (int i = 0; i < n; i++){
-        if (i < ncpu) {
-            rrCpuWait+= processes[i]->wait;
-        } else {
-            rrIoWait += processes[i]->wait;
+    if (w->names != NULL) {
+        for (int i = 0; ok && i < w->n; i++) {
+            const char* name = w->processes[i].name;
+            ok = fwrite(name, 1, strlen(name) + 1, fp) == strlen(name) + 1;
         }
     }
-    fprintf(fp, "-- CPU-bound average wait time: %.3f ms\n", ceil3(rrCpuWait / numCpuBurst));
-    fprintf(fp, "-- I/O-bound average wait time: %.3f ms\n", ceil3(rrIoWait / numIoBurst));
-    fprintf(fp, "-- overall average wait time: %.3f ms\n", ceil3( (rrCpuWait + rrIoWait) / (numCpuBurst+numIoBurst) ));
+    if (fclose(fp) != 0 || !ok) {
+        fprintf(stderr, "ERROR: Failed to write workload to %s\n", path);
+        return false;
+    }
+    return true;
+}
 
-    // calc turnaround time
-    double rrCpuTR = 0.0;
-    double rrIoTR = 0.0;
-    for (int i = 0; i < n; i++){
-        if (i < ncpu) {
-            rrCpuTR += processes[i]->turnaround;
-        } else {
-            rrIoTR += processes[i]->turnaround;
-        }
+// Map a workload written by saveWorkload; the burst arrays are used in place without parsing
+bool loadWorkload(Workload* w, const char* path){
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        perror("ERROR: open() failed");
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(WorkloadHeader)) {
+        fprintf(stderr, "ERROR: %s is not a workload trace\n", path);
+        close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    char* base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror("ERROR: mmap() failed");
+        return false;
     }
-    fprintf(fp, "-- CPU-bound average turnaround time: %.3f ms\n", ceil3((rrCpuTR- cpuIOBurst)/ numCpuBurst));
-    fprintf(fp, "-- I/O-bound average turnaround time: %.3f ms\n", ceil3((rrIoTR- ioIOBurst) / numIoBurst));
-    fprintf(fp, "-- overall average turnaround time: %.3f ms\n", ceil3( ((rrCpuTR- cpuIOBurst) + (rrIoTR- ioIOBurst)) / (numCpuBurst+numIoBurst) ));
 
-    // calc context switches
-    int RRCpuCs = 0;
-    int RRIoCs = 0;
-    for (int i = 0; i < n; i++){
-        if (i < ncpu) {
-            RRCpuCs += processes[i]->cs;
-        } else {
-            RRIoCs += processes[i]->cs;
-        }
+    const WorkloadHeader* header = (const WorkloadHeader*)base;
+    size_t n = header->n;
+    size_t niceCount = header->version >= 2 ? n : 0;
+    size_t deadlineCount = header->version >= 3 ? header->totalBursts : 0;
+    size_t expected = sizeof(WorkloadHeader) + n * (2 * sizeof(int32_t) + sizeof(uint64_t)) + niceCount * sizeof(int32_t)
+        + (2 * header->totalBursts + deadlineCount) * sizeof(int32_t);
+    if (memcmp(header->magic, WORKLOAD_MAGIC, sizeof(WORKLOAD_MAGIC)) != 0 || header->byteOrder != WORKLOAD_BYTE_ORDER) {
+        fprintf(stderr, "ERROR: %s is not a workload trace\n", path);
+        munmap(base, size);
+        return false;
+    }
+    // The names block takes the rest of a version 4 trace
+    size_t namesSize = header->version >= 4 && size > expected ? size - expected : 0;
+    if (header->version < 1 || header->version > WORKLOAD_VERSION || size != expected + namesSize || n > INT_MAX) {
+        fprintf(stderr, "ERROR: %s has an unsupported version or is truncated\n", path);
+        munmap(base, size);
+        return false;
     }
-    fprintf(fp, "-- CPU-bound number of context switches: %d\n", RRCpuCs);
-    fprintf(fp, "-- I/O-bound number of context switches: %d\n", RRIoCs);
-    fprintf(fp, "-- overall number of context switches: %d\n", RRCpuCs + RRIoCs);
 
-    // calc preemptions
-    int cpuPre = 0;
-    int ioPre = 0;
-    for (int i = 0; i < n; i++){
-        if (i < ncpu) {
-            cpuPre += processes[i]->preemptions;
-        } else {
-            ioPre += processes[i]->preemptions;
+    const int32_t* arrival = (const int32_t*)(base + sizeof(WorkloadHeader));
+    const int32_t* numBursts = arrival + n;
+    const uint64_t* offsets = (const uint64_t*)(numBursts + n);
+    const int32_t* nice = (const int32_t*)(offsets + n);
+    int32_t* cpuBursts = (int32_t*)(nice + niceCount);
+    int32_t* ioBursts = cpuBursts + header->totalBursts;
+    // A trace of a workload without deadlines stores them all as 0
+    int32_t* deadlines = NULL;
+    for (size_t j = 0; j < deadlineCount; j++) {
+        if (ioBursts[header->totalBursts + j] != 0) {
+            deadlines = ioBursts + header->totalBursts;
+            break;
         }
     }
-    fprintf(fp, "-- CPU-bound number of preemptions: %d\n", cpuPre);
-    fprintf(fp, "-- I/O-bound number of preemptions: %d\n", ioPre);
-    fprintf(fp, "-- overall number of preemptions: %d\n", cpuPre + ioPre);
-    
-    // Additional RR algorithm stats
-    int cpuOneTS = 0;
-    int ioOneTS = 0;
-    for (int i = 0; i < n; i++){
-        if (i < ncpu) {
-            cpuOneTS += processes[i]->oneTS;
-        } else {
-            ioOneTS += processes[i]->oneTS;
+    char* names = namesSize > 0 ? base + expected : NULL;
+
+    w->n = n;
+    w->ncpu = header->ncpu;
+    w->seed = header->seed;
+    w->lambda = header->lambda;
+    w->upperBound = header->upperBound;
+    w->bursts = NULL;
+    w->totalBursts = 2 * header->totalBursts;
+    w->deadlines = deadlines;
+    w->mapping = base;
+    w->mappingSize = size;
+    w->processes = calloc(n, sizeof(ProcessInfo));
+    numberProcesses(w);
+    w->names = names;
+    const char* name = names;
+    for (size_t i = 0; i < n; i++) {
+        ProcessInfo* p = w->processes + i;
+        if (numBursts[i] < 1 || offsets[i] + numBursts[i] > header->totalBursts) {
+            fprintf(stderr, "ERROR: %s has an invalid burst table\n", path);
+            freeWorkload(w);
+            return false;
         }
+        if (names != NULL) {
+            const char* end = name < names + namesSize ? memchr(name, '\0', names + namesSize - name) : NULL;
+            if (end == NULL) {
+                fprintf(stderr, "ERROR: %s has an invalid names block\n", path);
+                freeWorkload(w);
+                return false;
+            }
+            p->name = name;
+            name = end + 1;
+        }
+        p->arrivalTime = arrival[i];
+        p->numBursts = numBursts[i];
+        p->cpuBursts = cpuBursts + offsets[i];
+        p->ioBursts = ioBursts + offsets[i];
+        p->nice = niceCount > 0 ? nice[i] : 0;
+        p->deadlines = deadlines != NULL ? deadlines + offsets[i] : NULL;
     }
-    fprintf(fp, "-- CPU-bound percentage of CPU bursts completed within one time slice: %.3f%%\n", ceil3(100.0 * cpuOneTS/numCpuBurst) );
-    fprintf(fp, "-- I/O-bound percentage of CPU bursts completed within one time slice: %.3f%%\n", ceil3(100.0 * ioOneTS/numIoBurst) );
-    fprintf(fp, "-- overall percentage of CPU bursts completed within one time slice: %.3f%%\n", ceil3( (100.0 *(cpuOneTS + ioOneTS)/(numCpuBurst + numIoBurst)) ));
-    fclose(fp);
+    if (names != NULL && name != names + namesSize) {
+        fprintf(stderr, "ERROR: %s has an invalid names block\n", path);
+        freeWorkload(w);
+        return false;
+    }
+    summarizeWorkload(w);
+    return true;
+}
 
-    // Clean up
-    for (int i = 0; i < n; i++){
-        free((*(processes+i))->pid);
-        free((*(processes+i))->cpuBursts);
-        free((*(processes+i))->ioBursts);
-        free((*(processes+i))->remainingBursts);
-        free(*(processes+i));
+//----------------------------------------------------------------------------------------------------------------------------
+// Trace import
+// Streams a recorded trace into a workload one line at a time, only the bursts themselves are kept.
+// CSV: pid,arrival,kind,duration with kind "cpu" or "io" and times in ms; rows of a pid are in time order.
+// A "nice" row carries the process's nice value (-20 to 19) in the duration field instead, and a "deadline"
+// row the relative deadline in ms of the process's latest CPU burst.
+// perf: the default output of "perf sched timehist", one line per switch-out with wait, sch delay and run time.
+
+#define IMPORT_LINE_MAX 4096
+#define IMPORT_TABLE_MIN 1024
+
+// Process being built from the trace
+typedef struct {
+    char* pid;
+    double arrival;     // Absolute, rebased to the earliest arrival once the trace is read
+    int* cpuBursts;
+    int* ioBursts;
+    int numBursts;
+    int capacity;
+    bool inIo;          // Last record was an I/O burst, the next CPU record starts a new burst
+    double cpuExact;    // Unrounded lengths of the latest CPU and I/O bursts, which may span several records
+    double ioExact;
+    long cpuTotal;
+    long ioTotal;
+    int nice;
+    int* deadlines;     // Per CPU burst, 0 for none
+} ImportedProcess;
+
+typedef struct {
+    ImportedProcess* procs;
+    int n;
+    int capacity;
+    int* table;         // Open addressing pid -> index into procs, -1 when empty
+    int tableSize;
+    bool hasDeadlines;  // Some burst has a deadline
+} Importer;
+
+unsigned long hashPid(const char* s){
+    unsigned long h = 5381;
+    while (*s) {
+        h = h * 33 + (unsigned char)*s++;
     }
-    free(processes);
+    return h;
+}
+
+void growImportTable(Importer* im){
+    int size = im->tableSize == 0 ? IMPORT_TABLE_MIN : im->tableSize * 2;
+    int* table = malloc(size * sizeof(int));
+    for (int i = 0; i < size; i++) {
+        table[i] = -1;
+    }
+    for (int i = 0; i < im->n; i++) {
+        unsigned long slot = hashPid(im->procs[i].pid) & (size - 1);
+        while (table[slot] != -1) {
+            slot = (slot + 1) & (size - 1);
+        }
+        table[slot] = i;
+    }
+    free(im->table);
+    im->table = table;
+    im->tableSize = size;
+}
 
-}
\ No newline at end of file
+// Find the process named pid, adding it with the given arrival if it is new
+ImportedProcess* findImported(Importer* im, const char* pid, double arrival){
+    // Keep the table at most half full
+    if (2 * (im->n + 1) > im->tableSize) {
+        growImportTable(im);
+    }
+    unsigned long slot = hashPid(pid) & (im->tableSize - 1);
+    while (im->table[slot] != -1) {
+        if (strcmp(im->procs[im->table[slot]].pid, pid) == 0) {
+            return im->procs + im->table[slot];
+        }
+        slot = (slot + 1) & (im->tableSize - 1);
+    }
+    if (im->n == im->capacity) {
+        im->capacity = im->capacity == 0 ? 64 : im->capacity * 2;
+        im->procs = realloc(im->procs, im->capacity * sizeof(ImportedProcess));
+    }
+    ImportedProcess* p = im->procs + im->n;
+    memset(p, 0, sizeof(ImportedProcess));
+    p->pid = strdup(pid);
+    p->arrival = arrival;
+    p->inIo = true;
+    im->table[slot] = im->n++;
+    return p;
+}
+
+// Whole ms of an imported burst, rounded up once the records of the burst are summed.
+// The tolerance keeps the error of adding decimal fractions from rounding an exact sum up.
+int importedMs(double ms){
+    return (int)ceil(ms - 1e-6);
+}
+
+// Add a CPU burst of `ms` ms, merging it into the current one unless an I/O burst came in between
+void addImportedCpu(ImportedProcess* p, double ms){
+    if (!p->inIo) {
+        p->cpuExact += ms;
+    } else {
+        if (p->numBursts == p->capacity) {
+            p->capacity = p->capacity == 0 ? 8 : p->capacity * 2;
+            p->cpuBursts = realloc(p->cpuBursts, (p->capacity + 1) * sizeof(int));
+            p->ioBursts = realloc(p->ioBursts, p->capacity * sizeof(int));
+            p->deadlines = realloc(p->deadlines, p->capacity * sizeof(int));
+        }
+        p->cpuBursts[p->numBursts] = 0;
+        p->ioBursts[p->numBursts] = 0;
+        p->deadlines[p->numBursts] = 0;
+        p->numBursts++;
+        p->inIo = false;
+        p->cpuExact = ms;
+    }
+    int burst = importedMs(p->cpuExact);
+    p->cpuTotal += burst - p->cpuBursts[p->numBursts - 1];
+    p->cpuBursts[p->numBursts - 1] = burst;
+}
+
+// Add an I/O burst of `ms` ms after the current CPU burst; I/O before the first CPU burst only delays the arrival
+void addImportedIo(ImportedProcess* p, double ms){
+    if (p->numBursts == 0) {
+        p->arrival += ms;
+        return;
+    }
+    p->ioExact = p->inIo ? p->ioExact + ms : ms;
+    int burst = importedMs(p->ioExact);
+    p->ioTotal += burst - p->ioBursts[p->numBursts - 1];
+    p->ioBursts[p->numBursts - 1] = burst;
+    p->inIo = true;
+}
+
+// Trim surrounding whitespace in place
+char* trimField(char* s){
+    while (*s == ' ' || *s == '\t') {
+        s++;
+    }
+    char* end = s + strlen(s);
+    while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n')) {
+        end--;
+    }
+    *end = '\0';
+    return s;
+}
+
+// pid,arrival,kind,duration; returns false if the line is not a record
+bool importCsvLine(Importer* im, char* line){
+    char* fields[4];
+    char* rest = line;
+    for (int i = 0; i < 4; i++) {
+        fields[i] = rest;
+        char* comma = strchr(rest, ',');
+        if (comma == NULL && i < 3) {
+            return false;
+        }
+        if (comma != NULL) {
+            *comma = '\0';
+            rest = comma + 1;
+        }
+    }
+    char* end;
+    double arrival = strtod(fields[1], &end);
+    if (end == fields[1]) {
+        return false;
+    }
+    double duration = strtod(fields[3], &end);
+    if (end == fields[3]) {
+        return false;
+    }
+    char* kind = trimField(fields[2]);
+    if (strcmp(kind, "nice") == 0) {
+        if (duration < -20 || duration > 19) {
+            return false;
+        }
+        findImported(im, trimField(fields[0]), arrival)->nice = (int)duration;
+        return true;
+    }
+    if (strcmp(kind, "deadline") == 0) {
+        ImportedProcess* p = findImported(im, trimField(fields[0]), arrival);
+        if (duration <= 0 || duration > INT_MAX || p->numBursts == 0) {
+            return false;
+        }
+        p->deadlines[p->numBursts - 1] = (int)ceil(duration);
+        im->hasDeadlines = true;
+        return true;
+    }
+    if (duration < 0) {
+        return false;
+    }
+    ImportedProcess* p = findImported(im, trimField(fields[0]), arrival);
+    if (strcmp(kind, "cpu") == 0) {
+        if (duration > 0) {
+            addImportedCpu(p, duration);
+        }
+    } else if (strcmp(kind, "io") == 0) {
+        addImportedIo(p, duration);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// <time s> [<cpu>] <task> <wait ms> <sch delay ms> <run ms>; returns false if the line is not a record
+bool importPerfLine(Importer* im, char* line){
+    char* end;
+    double switchOut = strtod(line, &end) * 1000;
+    if (end == line) {
+        return false;
+    }
+    char* task = strchr(end, ']');
+    if (task == NULL) {
+        return false;
+    }
+    task++;
+    // The task name may contain spaces, so the three times are taken from the end of the line
+    double times[3];
+    char* last = trimField(task);
+    for (int i = 2; i >= 0; i--) {
+        char* space = strrchr(last, ' ');
+        if (space == NULL) {
+            return false;
+        }
+        times[i] = strtod(space + 1, &end);
+        if (end == space + 1) {
+            return false;
+        }
+        *space = '\0';
+        trimField(last);
+    }
+    task = trimField(last);
+    if (strcmp(task, "<idle>") == 0 || times[2] <= 0) {
+        return true;
+    }
+    double runStart = switchOut - times[2];
+    ImportedProcess* p = findImported(im, task, runStart - times[1]);
+    // A task that did not sleep since its last run was preempted and resumes the same burst
+    if (p->numBursts > 0 && times[0] > 0) {
+        addImportedIo(p, times[0]);
+    }
+    addImportedCpu(p, times[2]);
+    return true;
+}
+
+// Build a workload from a CSV or perf sched trace, "-" reads stdin.
+// Processes that spend more time on the CPU than in I/O are CPU-bound and placed first.
+bool importWorkload(Workload* w, const char* path){
+    FILE* fp = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (fp == NULL) {
+        perror("ERROR: fopen() failed");
+        return false;
+    }
+    Importer im;
+    memset(&im, 0, sizeof(im));
+    char line[IMPORT_LINE_MAX];
+    long lineNumber = 0;
+    int format = 0;     // 1 for CSV, 2 for perf, decided by the first record
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), fp) != NULL) {
+        lineNumber++;
+        size_t len = strlen(line);
+        if (len == sizeof(line) - 1 && line[len - 1] != '\n') {
+            fprintf(stderr, "ERROR: %s:%ld: line longer than %d characters\n", path, lineNumber, IMPORT_LINE_MAX - 2);
+            ok = false;
+            break;
+        }
+        char* s = trimField(line);
+        if (*s == '\0' || *s == '#') {
+            continue;
+        }
+        if (format == 0) {
+            format = strchr(s, ',') != NULL ? 1 : 2;
+        }
+        // Header and separator lines are not records and are skipped
+        if (format == 1) {
+            importCsvLine(&im, s);
+        } else {
+            importPerfLine(&im, s);
+        }
+    }
+    if (ferror(fp)) {
+        perror("ERROR: fgets() failed");
+        ok = false;
+    }
+    if (fp != stdin) {
+        fclose(fp);
+    }
+
+    // Drop processes that never ran
+    int kept = 0;
+    for (int i = 0; i < im.n; i++) {
+        if (im.procs[i].numBursts == 0) {
+            free(im.procs[i].pid);
+            free(im.procs[i].cpuBursts);
+            free(im.procs[i].ioBursts);
+            free(im.procs[i].deadlines);
+        } else {
+            im.procs[kept++] = im.procs[i];
+        }
+    }
+    if (ok && kept == 0) {
+        fprintf(stderr, "ERROR: %s has no CPU bursts\n", path);
+        ok = false;
+    }
+    if (!ok) {
+        for (int i = 0; i < kept; i++) {
+            free(im.procs[i].pid);
+            free(im.procs[i].cpuBursts);
+            free(im.procs[i].ioBursts);
+            free(im.procs[i].deadlines);
+        }
+        free(im.procs);
+        free(im.table);
+        return false;
+    }
+
+    double firstArrival = im.procs[0].arrival;
+    long cpuTotal = 0;
+    long numBursts = 0;
+    size_t namesSize = 0;
+    int ncpu = 0;
+    for (int i = 0; i < kept; i++) {
+        if (im.procs[i].arrival < firstArrival) {
+            firstArrival = im.procs[i].arrival;
+        }
+        if (im.procs[i].cpuTotal > im.procs[i].ioTotal) {
+            ncpu++;
+        }
+        cpuTotal += im.procs[i].cpuTotal;
+        numBursts += im.procs[i].numBursts;
+        namesSize += strlen(im.procs[i].pid) + 1;
+    }
+
+    w->n = kept;
+    w->ncpu = ncpu;
+    w->seed = 0;
+    // Initial tau of 1/lambda is the mean CPU burst of the trace
+    w->lambda = (double)numBursts / cpuTotal;
+    w->upperBound = 0;
+    w->mapping = NULL;
+    w->mappingSize = 0;
+    w->processes = calloc(kept, sizeof(ProcessInfo));
+    int cpuNext = 0;
+    int ioNext = ncpu;
+    for (int i = 0; i < kept; i++) {
+        ImportedProcess* src = im.procs + i;
+        ProcessInfo* p = w->processes + (src->cpuTotal > src->ioTotal ? cpuNext++ : ioNext++);
+        p->id = p - w->processes;
+        p->name = src->pid;
+        p->arrivalTime = (int)floor(src->arrival - firstArrival);
+        p->numBursts = src->numBursts;
+        p->cpuBursts = src->cpuBursts;
+        p->ioBursts = src->ioBursts;
+        p->deadlines = src->deadlines;
+        p->nice = src->nice;
+        // A trailing I/O burst has nothing after it to return to
+        p->ioBursts[p->numBursts - 1] = 0;
+    }
+    free(im.procs);
+    free(im.table);
+
+    // Move the bursts and names into the arenas, in the final process order
+    w->bursts = malloc(2 * numBursts * sizeof(int));
+    w->totalBursts = 2 * numBursts;
+    w->deadlines = im.hasDeadlines ? malloc(numBursts * sizeof(int)) : NULL;
+    w->names = malloc(namesSize);
+    long offset = 0;
+    char* name = w->names;
+    for (int i = 0; i < kept; i++) {
+        ProcessInfo* p = w->processes + i;
+        memcpy(w->bursts + offset, p->cpuBursts, p->numBursts * sizeof(int));
+        memcpy(w->bursts + offset + p->numBursts, p->ioBursts, p->numBursts * sizeof(int));
+        if (w->deadlines != NULL) {
+            memcpy(w->deadlines + offset / 2, p->deadlines, p->numBursts * sizeof(int));
+        }
+        offset += 2 * p->numBursts;
+        free(p->cpuBursts);
+        free(p->ioBursts);
+        free(p->deadlines);
+        strcpy(name, p->name);
+        free((char*)p->name);
+        p->name = name;
+        name += strlen(name) + 1;
+    }
+    attachBursts(w);
+    summarizeWorkload(w);
+    return true;
+}
+
+// Allocate the state of every process for one simulation of the workload
+// The states are one array and the remaining bursts one arena, in process order
+Process** createRunState(const ProcessInfo* workload, int n) {
+    Process** processes = simCalloc(n, sizeof(Process*));
+    Process* states = simCalloc(n, sizeof(Process));
+    long totalBursts = 0;
+    for (int i = 0; i < n; i++) {
+        totalBursts += workload[i].numBursts;
+    }
+    int* remaining = simCalloc(totalBursts, sizeof(int));
+    for (int i = 0; i < n; i++) {
+        *(processes+i) = states + i;
+        states[i].info = workload + i;
+        states[i].heapIndex = -1;
+        states[i].weight = niceWeight(workload[i].nice);
+        states[i].remainingBursts = remaining;
+        remaining += workload[i].numBursts;
+    }
+    return processes;
+}
+
+void freeRunState(Process** processes, int n) {
+    if (n > 0) {
+        free((*processes)->remainingBursts);
+        free(*processes);
+    }
+    free(processes);
+}
+
+typedef enum {ALG_FCFS, ALG_SJF, ALG_SRT, ALG_RR, ALG_CFS, ALG_MLFQ, ALG_STRIDE, ALG_LOTTERY, ALG_EDF, ALG_COUNT} Algorithm;
+
+const char* algorithmName(Algorithm a) {
+    switch (a) {
+        case ALG_FCFS:  return "FCFS";
+        case ALG_SJF:   return "SJF";
+        case ALG_SRT:   return "SRT";
+        case ALG_RR:    return "RR";
+        case ALG_CFS:   return "CFS";
+        case ALG_MLFQ:  return "MLFQ";
+        case ALG_STRIDE:    return "STRIDE";
+        case ALG_LOTTERY:   return "LOTTERY";
+        case ALG_EDF:   return "EDF";
+        default:        return "UNKNOWN";
+    }
+}
+
+// Algorithms that take alpha and t_slice, the other parameters are ignored in reports
+bool usesAlpha(Algorithm a) {
+    return a == ALG_SJF || a == ALG_SRT;
+}
+
+bool usesTimeSlice(Algorithm a) {
+    return a == ALG_RR || a == ALG_CFS || a == ALG_MLFQ || a == ALG_STRIDE || a == ALG_LOTTERY;
+}
+
+// Algorithms that share the CPU by tickets, every process holds DEFAULT_TICKETS unless set per class
+#define DEFAULT_TICKETS 100
+
+bool usesTickets(Algorithm a) {
+    return a == ALG_STRIDE || a == ALG_LOTTERY;
+}
+
+// Algorithms the multi-core simulation implements
+bool smpSupported(Algorithm a) {
+    return a == ALG_FCFS || a == ALG_SJF || a == ALG_SRT || a == ALG_RR;
+}
+
+// Algorithms that only run on workloads with deadlines
+bool needsDeadlines(Algorithm a) {
+    return a == ALG_EDF;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------
+// Multi-core simulation
+
+// Per-CPU results of a multi-core run
+typedef struct {
+    int cores;
+    long* busy;         // Time each CPU spent running bursts
+    int migrations;     // Bursts started on a different CPU than the previous burst of the process
+    int steals;         // Processes taken from another CPU's ready queue
+} CoreStats;
+
+// One simulated CPU with its own ready queue: a FIFO for FCFS/RR, a heap for SJF/SRT
+typedef struct {
+    bool useHeap;
+    Queue ready;
+    ReadyHeap heap;
+    Process* current;   // Process switching in or running, NULL when the CPU is free or switching out
+    bool started;       // current has started running its burst
+    int freeAt;         // Time the last process finishes switching out
+    int burstStart;     // Time current started or resumed its burst
+    int generation;     // Bumped on preemption so the pending burst events of current are ignored
+} Core;
+
+typedef struct {
+    Core* cores;
+    int numCores;
+    // Bit c of word c/64 is set while CPU c is idle / has a non-empty ready queue. They are updated whenever
+    // a CPU's ready queue or running process changes, so finding an idle CPU or a steal victim skips the others.
+    uint64_t* idleMask;
+    uint64_t* queuedMask;
+    int maskWords;
+    EventQueue eq;
+    Algorithm algorithm;
+    int tcs;
+    int tslice;
+    FILE* out;
+    CoreStats* stats;
+    LatencyStats* latency;
+} SmpSim;
+
+int coreReadySize(Core* core) {
+    return core->useHeap ? core->heap.size : core->ready.size;
+}
+
+// Next process to run on the CPU, NULL if its ready queue is empty
+Process* corePeek(Core* core) {
+    return core->useHeap ? readyHeapPeek(&core->heap) : peekQueue(&core->ready);
+}
+
+Process* corePop(Core* core) {
+    return core->useHeap ? readyHeapPop(&core->heap) : dequeue(&core->ready);
+}
+
+// CPU c's ready queue or running process changed
+void coreChanged(SmpSim* sim, int c) {
+    uint64_t bit = 1ULL << (c % 64);
+    int w = c / 64;
+    if (sim->cores[c].current == NULL) {
+        sim->idleMask[w] |= bit;
+    } else {
+        sim->idleMask[w] &= ~bit;
+    }
+    if (coreReadySize(sim->cores + c) > 0) {
+        sim->queuedMask[w] |= bit;
+    } else {
+        sim->queuedMask[w] &= ~bit;
+    }
+}
+
+// Lowest idle CPU, -1 if every CPU is busy
+int firstIdleCore(SmpSim* sim) {
+    for (int w = 0; w < sim->maskWords; w++) {
+        if (sim->idleMask[w] != 0) {
+            return w * 64 + __builtin_ctzll(sim->idleMask[w]);
+        }
+    }
+    return -1;
+}
+
+// Least loaded CPU counting its ready queue and running process, the lowest one on ties.
+// An idle CPU with an empty queue has no load, so the scan is only needed when there is none.
+int leastLoadedCore(SmpSim* sim) {
+    for (int w = 0; w < sim->maskWords; w++) {
+        uint64_t unloaded = sim->idleMask[w] & ~sim->queuedMask[w];
+        if (unloaded != 0) {
+            return w * 64 + __builtin_ctzll(unloaded);
+        }
+    }
+    int c = 0;
+    for (int i = 1; i < sim->numCores; i++) {
+        int load = coreReadySize(sim->cores + i) + (sim->cores[i].current != NULL);
+        int best = coreReadySize(sim->cores + c) + (sim->cores[c].current != NULL);
+        if (load < best) {
+            c = i;
+        }
+    }
+    return c;
+}
+
+// Print the ready queue of CPU c and end the log line
+void printCoreQueue(FILE* out, Core* core, int c) {
+    fprintf(out, " [Q%d", c);
+    if (core->useHeap) {
+        printReadyHeap(out, &core->heap);
+    } else {
+        printQueue(out, &core->ready);
+    }
+    fprintf(out, "]\n");
+}
+
+// Print "time Xms: Process P" with the process's tau for SJF/SRT
+void printProcessPrefix(SmpSim* sim, int time, Process* p) {
+    if (sim->algorithm == ALG_SJF || sim->algorithm == ALG_SRT) {
+        fprintf(sim->out, "time %dms: Process %s (tau %dms)", time, pidName(p->info), p->tau);
+    } else {
+        fprintf(sim->out, "time %dms: Process %s", time, pidName(p->info));
+    }
+}
+
+// Add a process to a CPU's ready queue in the order of the algorithm
+void smpEnqueue(Core* core, Process* p) {
+    if (core->useHeap) {
+        readyHeapPush(&core->heap, p, predictedRemaining(p));
+    } else {
+        enqueue(&core->ready, p);
+    }
+}
+
+// Take the next process from the CPU with the longest ready queue
+Process* stealProcess(SmpSim* sim, int thief) {
+    int victim = -1;
+    for (int w = 0; w < sim->maskWords; w++) {
+        for (uint64_t queued = sim->queuedMask[w]; queued != 0; queued &= queued - 1) {
+            int c = w * 64 + __builtin_ctzll(queued);
+            if (c != thief && (victim == -1 || coreReadySize(sim->cores + c) > coreReadySize(sim->cores + victim))) {
+                victim = c;
+            }
+        }
+    }
+    if (victim == -1) {
+        return NULL;
+    }
+    sim->stats->steals++;
+    Process* p = corePop(sim->cores + victim);
+    coreChanged(sim, victim);
+    return p;
+}
+
+// Switch the next process onto CPU c, stealing one if its own ready queue is empty
+void smpDispatch(SmpSim* sim, int c, int time) {
+    Core* core = sim->cores + c;
+    Process* next = corePop(core);
+    if (next == NULL) {
+        next = stealProcess(sim, c);
+        if (next == NULL) {
+            return;
+        }
+    }
+    core->current = next;
+    core->started = false;
+    if (next->lastCore != -1 && next->lastCore != c) {
+        sim->stats->migrations++;
+    }
+    next->lastCore = c;
+    coreChanged(sim, c);
+
+    int at = time > core->freeAt ? time : core->freeAt;
+    Event* e = createEvent(&sim->eq, next, at + sim->tcs/2, READY);
+    e->core = c;
+    insertEvent(&sim->eq, e);
+}
+
+// Take the process off CPU c before its burst completes and send it back to a ready queue
+void smpPreempt(SmpSim* sim, int c, int time) {
+    Core* core = sim->cores + c;
+    Process* p = core->current;
+    int idx = p->info->numBursts - p->burstsLeft;
+    int ran = time - core->burstStart;
+    sim->stats->busy[c] += ran;
+    p->remainingBursts[idx] -= ran;
+    p->preemptions++;
+    core->generation++;
+    core->current = NULL;
+    core->freeAt = time + sim->tcs/2;
+    coreChanged(sim, c);
+
+    Event* e = createEvent(&sim->eq, p, time + sim->tcs/2, ENQUEUE);
+    e->core = c;
+    insertEvent(&sim->eq, e);
+}
+
+// SRT: preempt CPU c if the head of its ready queue is predicted to finish before the running process
+// Returns true if the running process was preempted
+bool smpCheckPreemption(SmpSim* sim, int c, int time) {
+    Core* core = sim->cores + c;
+    Process* next = corePeek(core);
+    Process* p = core->current;
+    if (next == NULL || p == NULL || !core->started) {
+        return false;
+    }
+    if (predictedRemaining(next) >= predictedRemaining(p) - (time - core->burstStart)) {
+        return false;
+    }
+    if (TRACING(sim->out, time)) {
+        printProcessPrefix(sim, time, next);
+        fprintf(sim->out, " will preempt %s on CPU %d", pidName(p->info), c);
+        printCoreQueue(sim->out, core, c);
+    }
+    smpPreempt(sim, c, time);
+    smpDispatch(sim, c, time);
+    return true;
+}
+
+// Put a process on a ready queue: the CPU it last ran on, or the least loaded CPU for a new process
+void smpMakeReady(SmpSim* sim, Process* p, int time, const char* what) {
+    int c = p->lastCore;
+    if (c == -1) {
+        c = leastLoadedCore(sim);
+    }
+    Core* core = sim->cores + c;
+    smpEnqueue(core, p);
+    coreChanged(sim, c);
+    if (what != NULL && TRACING(sim->out, time)) {
+        printProcessPrefix(sim, time, p);
+        fprintf(sim->out, " %s; added to ready queue of CPU %d", what, c);
+        printCoreQueue(sim->out, core, c);
+    }
+
+    if (core->current == NULL) {
+        smpDispatch(sim, c, time);
+        return;
+    }
+    // Let an idle CPU steal the work
+    int idle = firstIdleCore(sim);
+    if (idle != -1) {
+        smpDispatch(sim, idle, time);
+        return;
+    }
+    if (sim->algorithm == ALG_SRT) {
+        smpCheckPreemption(sim, c, time);
+    }
+}
+
+// Simulate an algorithm on stats->cores CPUs, each with its own ready queue
+int SMP(Process** processes, int n, Algorithm algorithm, int tcs, double alpha, double lambda, int tslice, FILE* out, CoreStats* stats, LatencyStats* latency) {
+    // Reset all processes
+    for (int i = 0; i < n; i++) {
+        Process* p = processes[i];
+        p->state = ARRIVE;
+        p->burstsLeft = p->info->numBursts;
+        p->tau = (int)ceil(1.0 / lambda);
+        for (int j = 0; j < p->info->numBursts; j++){
+            p->remainingBursts[j] = p->info->cpuBursts[j];
+        }
+        p->readyTime = 0;
+        p->wait = 0;
+        p->waitMark = 0;
+        p->startTime = 0;
+        p->turnaround = 0;
+        p->cs = 0;
+        p->preemptions = 0;
+        p->oneTS = 0;
+        p->deadlineBursts = 0;
+        p->deadlineMisses = 0;
+        p->lastCore = -1;
+    }
+
+    SmpSim sim = {NULL, stats->cores, NULL, NULL, 0, {0}, algorithm, tcs, tslice, out, stats, latency};
+    sim.cores = simCalloc(sim.numCores, sizeof(Core));
+    for (int c = 0; c < sim.numCores; c++) {
+        sim.cores[c].useHeap = algorithm == ALG_SJF || algorithm == ALG_SRT;
+        if (sim.cores[c].useHeap) {
+            initReadyHeap(&sim.cores[c].heap, n);
+        } else {
+            initQueue(&sim.cores[c].ready, n);
+        }
+        stats->busy[c] = 0;
+    }
+    stats->migrations = 0;
+    stats->steals = 0;
+    sim.maskWords = (sim.numCores + 63) / 64;
+    sim.idleMask = simCalloc(sim.maskWords, sizeof(uint64_t));
+    sim.queuedMask = simCalloc(sim.maskWords, sizeof(uint64_t));
+    for (int c = 0; c < sim.numCores; c++) {
+        coreChanged(&sim, c);
+    }
+    initEventQueue(&sim.eq, 2*n);
+    if (LOGGING(out)){
+        fprintf(out, "time 0ms: Simulator started for %s on %d CPUs [Q empty]\n", algorithmName(algorithm), sim.numCores);
+    }
+
+    // Arrivals
+    for (int i = 0; i < n; i++){
+        Event* newEvent = createEvent(&sim.eq, processes[i], processes[i]->info->arrivalTime, ARRIVE);
+        insertEvent(&sim.eq, newEvent);
+    }
+
+    int time = 0;
+    int terminatedCount = 0;
+    while (terminatedCount < n) {
+        // Handle Events
+        Event* e = popEvent(&sim.eq);
+        STAT_ADD(eventsByState[e->state], 1);
+        time = e->time;
+        Process* p = e->process;
+        int c = e->core;
+        Core* core = sim.cores + c;
+        int idx = p->info->numBursts - p->burstsLeft;
+
+        // Burst events of a preempted process
+        if ((e->state == RUNNING || e->state == PREEMPTION) && e->generation != core->generation) {
+            releaseEvent(&sim.eq, e);
+            continue;
+        }
+
+        if (e->state == ARRIVE || e->state == WAITING) {
+            // For writing to simout
+            p->startTime = time;    // Turnaround time
+            p->readyTime = time;    // Wait time
+            smpMakeReady(&sim, p, time, e->state == ARRIVE ? "arrived" : "completed I/O");
+        }
+        // Preempted process finished switching out
+        else if (e->state == ENQUEUE) {
+            p->readyTime = time;
+            smpMakeReady(&sim, p, time, NULL);
+        }
+        // Start or resume a CPU burst
+        else if (e->state == READY) {
+            p->cs++;                                        // Context Switch
+            p->wait += time - p->readyTime - tcs/2;         // Wait time
+            int remaining = p->remainingBursts[idx];
+            int fullBurst = p->info->cpuBursts[idx];
+            core->started = true;
+            core->burstStart = time;
+
+            // Print
+            if (TRACING(out, time)){
+                printProcessPrefix(&sim, time, p);
+                if (remaining != fullBurst){
+                    fprintf(out, " started using CPU %d for remaining %dms of %dms burst", c, remaining, fullBurst);
+                } else {
+                    fprintf(out, " started using CPU %d for %dms burst", c, fullBurst);
+                }
+                printCoreQueue(out, core, c);
+            }
+
+            // A process that became ready while this one was switching in may preempt it right away
+            if (algorithm == ALG_SRT && smpCheckPreemption(&sim, c, time)) {
+                releaseEvent(&sim.eq, e);
+                continue;
+            }
+
+            Event* endCpu;
+            if (algorithm == ALG_RR && tslice > 0 && remaining > tslice) {
+                endCpu = createEvent(&sim.eq, p, time + tslice, PREEMPTION);
+            } else {
+                endCpu = createEvent(&sim.eq, p, time + remaining, RUNNING);
+            }
+            endCpu->core = c;
+            endCpu->generation = core->generation;
+            insertEvent(&sim.eq, endCpu);
+        }
+        // RR time slice expired
+        else if (e->state == PREEMPTION) {
+            int ran = time - core->burstStart;
+            stats->busy[c] += ran;
+            p->remainingBursts[idx] -= ran;
+            core->burstStart = time;
+            int remaining = p->remainingBursts[idx];
+
+            if (coreReadySize(core) == 0) {
+                if (TRACING(out, time)){
+                    fprintf(out, "time %dms: Time slice expired on CPU %d; no preemption because ready queue is empty", time, c);
+                    printCoreQueue(out, core, c);
+                }
+                Event* endCpu;
+                if (tslice > 0 && remaining > tslice) {
+                    endCpu = createEvent(&sim.eq, p, time + tslice, PREEMPTION);
+                } else {
+                    endCpu = createEvent(&sim.eq, p, time + remaining, RUNNING);
+                }
+                endCpu->core = c;
+                endCpu->generation = core->generation;
+                insertEvent(&sim.eq, endCpu);
+            } else {
+                if (TRACING(out, time)){
+                    fprintf(out, "time %dms: Time slice expired on CPU %d; preempting process %s with %dms remaining", time, c, pidName(p->info), remaining);
+                    printCoreQueue(out, core, c);
+                }
+                // Nothing left to account for in smpPreempt
+                core->burstStart = time;
+                smpPreempt(&sim, c, time);
+                smpDispatch(&sim, c, time);
+            }
+        }
+        // CPU burst complete
+        else if (e->state == RUNNING) {
+            stats->busy[c] += time - core->burstStart;
+            p->remainingBursts[idx] = 0;
+            p->burstsLeft--;
+            p->turnaround += time + tcs/2 - p->startTime;  // Turnaround time
+            recordBurst(sim.latency, p, time + tcs/2 - p->startTime);
+            recordDeadline(sim.latency, p, idx, time - p->startTime);
+            if (algorithm == ALG_RR && p->info->cpuBursts[idx] <= tslice) {
+                p->oneTS++;
+            }
+            core->current = NULL;
+            core->freeAt = time + tcs/2;
+            coreChanged(&sim, c);
+
+            if (p->burstsLeft == 0) {
+                if (LOGGING(out)){
+                    fprintf(out, "time %dms: Process %s terminated on CPU %d", time, pidName(p->info), c);
+                    printCoreQueue(out, core, c);
+                }
+                terminatedCount++;
+            } else {
+                if (TRACING(out, time)){
+                    printProcessPrefix(&sim, time, p);
+                    fprintf(out, " completed a CPU burst on CPU %d; %d burst%s to go", c, p->burstsLeft, p->burstsLeft == 1 ? "" : "s");
+                    printCoreQueue(out, core, c);
+                }
+                // Recalculate tau after the CPU burst
+                if (algorithm == ALG_SJF || algorithm == ALG_SRT) {
+                    int oldTau = p->tau;
+                    p->tau = (int)ceil(alpha * p->info->cpuBursts[idx] + (1 - alpha) * oldTau);
+                    if (TRACING(out, time)){
+                        fprintf(out, "time %dms: Recalculated tau for process %s: old tau %dms ==> new tau %dms", time, pidName(p->info), oldTau, p->tau);
+                        printCoreQueue(out, core, c);
+                    }
+                }
+                // IO Burst start
+                int ioCompTime = time + p->info->ioBursts[idx] + tcs/2;
+                if (TRACING(out, time)){
+                    fprintf(out, "time %dms: Process %s switching out of CPU %d; blocking on I/O until time %dms", time, pidName(p->info), c, ioCompTime);
+                    printCoreQueue(out, core, c);
+                }
+                Event* ioBurst = createEvent(&sim.eq, p, ioCompTime, WAITING);
+                insertEvent(&sim.eq, ioBurst);
+            }
+            smpDispatch(&sim, c, time);
+        }
+        releaseEvent(&sim.eq, e);
+    }
+
+    time += tcs/2;
+#if LOG_LEVEL >= LOG_DEBUG
+    if (LOGGING(out)){
+        printEventPoolStats(out, &sim.eq);
+    }
+#endif
+    if (LOGGING(out)){
+        fprintf(out, "time %dms: Simulator ended for %s on %d CPUs [Q empty]\n\n", time, algorithmName(algorithm), sim.numCores);
+    }
+    simCounters.events += sim.eq.eventsCreated;
+    freeEventQueue(&sim.eq);
+    for (int c = 0; c < sim.numCores; c++) {
+        free(sim.cores[c].ready.procs);
+        free(sim.cores[c].heap.procs);
+    }
+    free(sim.cores);
+    free(sim.idleMask);
+    free(sim.queuedMask);
+    return time;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------
+// Event log sink
+// Each simulation formats its log into its own ring buffer through a FILE; a writer thread drains the rings
+// in simulation order with large writes, so the output matches running the simulations one after another.
+
+#define LOG_RING_SIZE (1 << 20)
+#define LOG_STREAM_BUFFER (64 * 1024)
+
+typedef struct {
+    char* data;
+    size_t head;        // Total bytes drained, data[head % LOG_RING_SIZE] is the next to write
+    size_t tail;        // Total bytes produced
+    bool closed;
+} LogRing;
+
+typedef struct {
+    LogRing* rings;
+    int count;
+    int fd;
+    bool failed;
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} LogSink;
+
+// Cookie of a simulation's log FILE
+typedef struct {
+    LogSink* sink;
+    LogRing* ring;
+} LogStream;
+
+ssize_t logStreamWrite(void* cookie, const char* buf, size_t size) {
+    LogStream* s = cookie;
+    LogSink* sink = s->sink;
+    LogRing* ring = s->ring;
+    size_t written = 0;
+    pthread_mutex_lock(&sink->lock);
+    while (written < size) {
+        // Wait for the writer to drain this ring, which happens once the earlier simulations are done
+        while (ring->tail - ring->head == LOG_RING_SIZE && !sink->failed) {
+            pthread_cond_wait(&sink->changed, &sink->lock);
+        }
+        if (sink->failed) {
+            break;
+        }
+        size_t at = ring->tail % LOG_RING_SIZE;
+        size_t len = LOG_RING_SIZE - (ring->tail - ring->head);
+        if (len > LOG_RING_SIZE - at) len = LOG_RING_SIZE - at;
+        if (len > size - written) len = size - written;
+        memcpy(ring->data + at, buf + written, len);
+        ring->tail += len;
+        written += len;
+        pthread_cond_broadcast(&sink->changed);
+    }
+    pthread_mutex_unlock(&sink->lock);
+    // Once the writer has failed the log is discarded rather than stalling the simulation
+    return size;
+}
+
+// Mark a simulation's log complete so the writer moves on to the next one
+void closeLogRing(LogSink* sink, LogRing* ring) {
+    pthread_mutex_lock(&sink->lock);
+    ring->closed = true;
+    pthread_cond_broadcast(&sink->changed);
+    pthread_mutex_unlock(&sink->lock);
+}
+
+int logStreamClose(void* cookie) {
+    LogStream* s = cookie;
+    closeLogRing(s->sink, s->ring);
+    free(s);
+    return 0;
+}
+
+// Open the FILE a simulation writes its log to
+FILE* openLogStream(LogSink* sink, LogRing* ring) {
+    LogStream* s = malloc(sizeof(LogStream));
+    s->sink = sink;
+    s->ring = ring;
+    cookie_io_functions_t io = {NULL, logStreamWrite, NULL, logStreamClose};
+    FILE* out = fopencookie(s, "w", io);
+    if (out == NULL) {
+        free(s);
+        return NULL;
+    }
+    setvbuf(out, NULL, _IOFBF, LOG_STREAM_BUFFER);
+    return out;
+}
+
+void* logWriter(void* arg) {
+    LogSink* sink = arg;
+    pthread_mutex_lock(&sink->lock);
+    for (int k = 0; k < sink->count && !sink->failed; k++) {
+        LogRing* ring = sink->rings + k;
+        while (true) {
+            while (ring->tail == ring->head && !ring->closed) {
+                pthread_cond_wait(&sink->changed, &sink->lock);
+            }
+            if (ring->tail == ring->head) {
+                break;
+            }
+            // Everything up to the end of the data or of the buffer goes out in one write
+            size_t at = ring->head % LOG_RING_SIZE;
+            size_t len = ring->tail - ring->head;
+            if (len > LOG_RING_SIZE - at) len = LOG_RING_SIZE - at;
+            pthread_mutex_unlock(&sink->lock);
+            size_t done = 0;
+            while (done < len) {
+                ssize_t n = write(sink->fd, ring->data + at + done, len - done);
+                if (n < 0) {
+                    perror("ERROR: write() failed");
+                    break;
+                }
+                done += n;
+            }
+            pthread_mutex_lock(&sink->lock);
+            if (done < len) {
+                sink->failed = true;
+                pthread_cond_broadcast(&sink->changed);
+                break;
+            }
+            ring->head += len;
+            pthread_cond_broadcast(&sink->changed);
+        }
+    }
+    pthread_mutex_unlock(&sink->lock);
+    return NULL;
+}
+
+// Start a writer thread copying the logs of count simulations to fd, returns false if it could not start
+bool startLogSink(LogSink* sink, int count, int fd) {
+    sink->rings = calloc(count, sizeof(LogRing));
+    for (int k = 0; k < count; k++) {
+        sink->rings[k].data = malloc(LOG_RING_SIZE);
+    }
+    sink->count = count;
+    sink->fd = fd;
+    sink->failed = false;
+    pthread_mutex_init(&sink->lock, NULL);
+    pthread_cond_init(&sink->changed, NULL);
+    if (pthread_create(&sink->writer, NULL, logWriter, sink) != 0) {
+        perror("ERROR: pthread_create() failed");
+        for (int k = 0; k < count; k++) {
+            free(sink->rings[k].data);
+        }
+        free(sink->rings);
+        sink->rings = NULL;
+        sink->count = 0;
+        return false;
+    }
+    return true;
+}
+
+// Wait for every log to be written once all simulations have closed their streams
+void finishLogSink(LogSink* sink) {
+    if (sink->count > 0) {
+        pthread_join(sink->writer, NULL);
+    }
+    for (int k = 0; k < sink->count; k++) {
+        free(sink->rings[k].data);
+    }
+    free(sink->rings);
+    pthread_mutex_destroy(&sink->lock);
+    pthread_cond_destroy(&sink->changed);
+}
+
+// Metrics written to simout for one simulation, before rounding
+// Averages are per CPU burst; cpu/io prefixes are the CPU-bound and I/O-bound processes
+typedef struct {
+    double utilization;
+    double cpuWait;
+    double ioWait;
+    double wait;
+    double cpuTurnaround;
+    double ioTurnaround;
+    double turnaround;
+    int cpuCs;
+    int ioCs;
+    int cpuPreemptions;
+    int ioPreemptions;
+    // RR: percentage of CPU bursts completed within one time slice
+    double cpuOneTS;
+    double ioOneTS;
+    double oneTS;
+    // Jain's index of the weighted CPU share the processes got while runnable, 1 is perfectly fair
+    double fairness;
+    // Stride/lottery: percentage of the contended CPU time each class was entitled to by its tickets and received
+    double cpuEntitled;
+    double ioEntitled;
+    double cpuShare;
+    double ioShare;
+    // Completed CPU bursts that had a deadline, and those that missed it
+    int cpuDeadlines;
+    int ioDeadlines;
+    int cpuMisses;
+    int ioMisses;
+} SimMetrics;
+
+// Totals of one process at the end of a simulation
+typedef struct {
+    int wait;
+    int turnaround;
+    int cs;
+    int preemptions;
+    int deadlineBursts;
+    int deadlineMisses;
+} ProcessResult;
+
+// MLFQ levels used when none are given: slices double from t_slice at each level down,
+// boosted every MLFQ_BOOST_SLICES time slices
+#define MLFQ_DEFAULT_LEVELS 3
+#define MLFQ_BOOST_SLICES 32
+
+void defaultMlfqConfig(MlfqConfig* config, int levels, int tslice) {
+    int quantum = tslice > 0 ? tslice : 1;
+    config->levels = levels;
+    for (int l = 0; l < levels; l++) {
+        config->quanta[l] = quantum;
+        quantum = quantum > INT_MAX / 2 ? INT_MAX : quantum * 2;
+    }
+    config->boost = MLFQ_BOOST_SLICES * (tslice > 0 ? tslice : 1);
+}
+
+// One simulation: the algorithm and its parameters, its buffered output and its metrics
+typedef struct {
+    Algorithm algorithm;
+    const Workload* workload;
+    int tcs;
+    double alpha;
+    int tslice;
+    MlfqConfig mlfq;    // levels == 0 uses MLFQ levels derived from tslice
+    int tickets[2];     // Stride/lottery tickets of each CPU-bound and I/O-bound process, 0 uses DEFAULT_TICKETS
+    int cores;          // Simulated CPUs, 0 or 1 runs the single CPU simulation
+    LogSink* log;       // Sink the event log is written to, NULL discards it
+    LogRing* logRing;
+    LatencyStats* latency;  // Per-burst distributions filled in by the simulation, NULL skips them
+    bool keepProcesses;     // Copy the per-process totals into processes
+    // Results
+    int endTime;
+    SimMetrics metrics;
+    CoreStats coreStats;
+    ProcessResult* processes;
+#ifdef STATS
+    SimStats stats;
+#endif
+} SimRun;
+
+// helper for rounding to write to simout
+double ceil3(double value) {
+    return ceil(value * 1000) / 1000;
+}
+
+// Seconds between two CLOCK_MONOTONIC readings
+double elapsedSeconds(const struct timespec* start, const struct timespec* end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Compute the simout metrics of a finished simulation from its process state
+void computeMetrics(SimRun* run, Process** processes) {
+    const Workload* w = run->workload;
+    SimMetrics* m = &run->metrics;
+    memset(m, 0, sizeof(SimMetrics));
+    if (run->cores > 1) {
+        m->utilization = (w->cpuBoundBurst + w->ioBoundBurst)/((double)run->endTime * run->cores) * 100;
+    } else {
+        m->utilization = (w->cpuBoundBurst + w->ioBoundBurst)/run->endTime * 100;
+    }
+
+    double cpuWait = 0.0;
+    double ioWait = 0.0;
+    double cpuTR = 0.0;
+    double ioTR = 0.0;
+    int cpuOneTS = 0;
+    int ioOneTS = 0;
+    double shareSum = 0.0;
+    double shareSquares = 0.0;
+    double cpuEntitled = 0.0;
+    double ioEntitled = 0.0;
+    long cpuContended = 0;
+    long ioContended = 0;
+    for (int i = 0; i < w->n; i++){
+        // Fraction of its runnable time the process spent on the CPU, per unit of weight
+        long cpuTime = 0;
+        for (int j = 0; j < w->processes[i].numBursts; j++) {
+            cpuTime += w->processes[i].cpuBursts[j];
+        }
+        double share = (double)cpuTime / (cpuTime + processes[i]->wait) * NICE_0_WEIGHT / processes[i]->weight;
+        shareSum += share;
+        shareSquares += share * share;
+        cpuEntitled += processes[i]->entitledTime[0];
+        ioEntitled += processes[i]->entitledTime[1];
+
+        if (i < w->ncpu) {
+            cpuContended += processes[i]->contendedTime;
+            cpuWait += processes[i]->wait;
+            cpuTR += processes[i]->turnaround;
+            m->cpuCs += processes[i]->cs;
+            m->cpuPreemptions += processes[i]->preemptions;
+            m->cpuDeadlines += processes[i]->deadlineBursts;
+            m->cpuMisses += processes[i]->deadlineMisses;
+            cpuOneTS += processes[i]->oneTS;
+        } else {
+            ioContended += processes[i]->contendedTime;
+            ioWait += processes[i]->wait;
+            ioTR += processes[i]->turnaround;
+            m->ioCs += processes[i]->cs;
+            m->ioPreemptions += processes[i]->preemptions;
+            m->ioDeadlines += processes[i]->deadlineBursts;
+            m->ioMisses += processes[i]->deadlineMisses;
+            ioOneTS += processes[i]->oneTS;
+        }
+    }
+
+    m->cpuWait = cpuWait / w->numCpuBurst;
+    m->ioWait = ioWait / w->numIoBurst;
+    m->wait = (cpuWait + ioWait) / (w->numCpuBurst+w->numIoBurst);
+    m->cpuTurnaround = cpuTR / w->numCpuBurst;
+    m->ioTurnaround = ioTR / w->numIoBurst;
+    m->turnaround = (cpuTR + ioTR) / (w->numCpuBurst+w->numIoBurst);
+    m->cpuOneTS = 100.0 * cpuOneTS/w->numCpuBurst;
+    m->ioOneTS = 100.0 * ioOneTS/w->numIoBurst;
+    m->oneTS = (100.0 *(cpuOneTS + ioOneTS)/(w->numCpuBurst + w->numIoBurst));
+    m->fairness = shareSquares > 0 ? shareSum * shareSum / (w->n * shareSquares) : 1.0;
+    long contended = cpuContended + ioContended;
+    if (contended > 0) {
+        m->cpuEntitled = 100.0 * cpuEntitled / contended;
+        m->ioEntitled = 100.0 * ioEntitled / contended;
+        m->cpuShare = 100.0 * cpuContended / contended;
+        m->ioShare = 100.0 * ioContended / contended;
+    }
+}
+
+// Run one simulation on its own process state, keeping its log and metrics
+void runSimulation(SimRun* run) {
+    const Workload* w = run->workload;
+    Process** processes = createRunState(w->processes, w->n);
+    for (int i = 0; i < w->n; i++) {
+        processes[i]->ticketClass = i < w->ncpu ? 0 : 1;
+        int tickets = run->tickets[processes[i]->ticketClass];
+        processes[i]->tickets = tickets > 0 ? tickets : DEFAULT_TICKETS;
+    }
+    if (run->latency != NULL) {
+        memset(run->latency, 0, sizeof(LatencyStats));
+        run->latency->ncpu = w->ncpu;
+    }
+#ifdef STATS
+    // The counters are per thread and simulations run one at a time on each, so they are reset around the run
+    simStats = (SimStats){0};
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+#endif
+    FILE* out = NULL;
+    if (run->log != NULL) {
+        out = openLogStream(run->log, run->logRing);
+        if (out == NULL) {
+            perror("ERROR: fopencookie() failed");
+            closeLogRing(run->log, run->logRing);
+        }
+    }
+    if (run->cores > 1) {
+        run->coreStats.cores = run->cores;
+        run->coreStats.busy = simCalloc(run->cores, sizeof(long));
+        run->endTime = SMP(processes, w->n, run->algorithm, run->tcs, run->alpha, w->lambda, run->tslice, out, &run->coreStats, run->latency);
+    } else {
+        switch (run->algorithm) {
+            case ALG_FCFS: run->endTime = FCFS(processes, w->n, run->tcs, w->lambda, out, run->latency); break;
+            case ALG_SJF:  run->endTime = SJF(processes, w->n, run->tcs, run->alpha, w->lambda, out, run->latency); break;
+            case ALG_SRT:  run->endTime = SRT(processes, w->n, run->tcs, run->alpha, w->lambda, out, run->latency); break;
+            case ALG_RR:   run->endTime = RR(processes, w->n, run->tcs, run->tslice, w->lambda, out, run->latency); break;
+            case ALG_CFS:  run->endTime = CFS(processes, w->n, run->tcs, run->tslice, w->lambda, out, run->latency); break;
+            case ALG_MLFQ: {
+                MlfqConfig config = run->mlfq;
+                if (config.levels == 0) {
+                    defaultMlfqConfig(&config, MLFQ_DEFAULT_LEVELS, run->tslice);
+                }
+                run->endTime = MLFQ(processes, w->n, run->tcs, &config, w->lambda, out, run->latency);
+                break;
+            }
+            case ALG_STRIDE:  run->endTime = STRIDE(processes, w->n, run->tcs, run->tslice, w->lambda, out, run->latency); break;
+            case ALG_LOTTERY: run->endTime = LOTTERY(processes, w->n, run->tcs, run->tslice, w->seed, w->lambda, out, run->latency); break;
+            case ALG_EDF:     run->endTime = EDF(processes, w->n, run->tcs, w->lambda, out, run->latency); break;
+            default:       break;
+        }
+    }
+    if (out != NULL) {
+        fclose(out);
+    }
+#ifdef STATS
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    simStats.seconds = elapsedSeconds(&start, &end);
+    run->stats = simStats;
+#endif
+    computeMetrics(run, processes);
+    if (run->keepProcesses) {
+        run->processes = calloc(w->n, sizeof(ProcessResult));
+        for (int i = 0; i < w->n; i++) {
+            run->processes[i] = (ProcessResult){processes[i]->wait, processes[i]->turnaround, processes[i]->cs, processes[i]->preemptions,
+                                                processes[i]->deadlineBursts, processes[i]->deadlineMisses};
+        }
+    }
+    freeRunState(processes, w->n);
+}
+
+void freeSimRun(SimRun* run) {
+    free(run->coreStats.busy);
+    run->coreStats.busy = NULL;
+    free(run->processes);
+    run->processes = NULL;
+}
+
+// Worker threads take the next unclaimed task until all tasks are done
+typedef struct {
+    char* tasks;
+    size_t taskSize;
+    int count;
+    int next;
+    void (*run)(void*);
+    pthread_mutex_t lock;
+} TaskPool;
+
+void* taskWorker(void* arg) {
+    TaskPool* pool = arg;
+    while (true) {
+        pthread_mutex_lock(&pool->lock);
+        int i = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        if (i >= pool->count) {
+            break;
+        }
+        pool->run(pool->tasks + i * pool->taskSize);
+    }
+    return NULL;
+}
+
+// Call run on each of the count tasks (each taskSize bytes) using up to `threads` worker threads
+void runTasks(void* tasks, size_t taskSize, int count, void (*run)(void*), int threads) {
+    if (threads > count) threads = count;
+    if (threads < 1) threads = 1;
+    TaskPool pool = {tasks, taskSize, count, 0, run, PTHREAD_MUTEX_INITIALIZER};
+    pthread_t* workers = calloc(threads, sizeof(pthread_t));
+    int started = 0;
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(workers + i, NULL, taskWorker, &pool) != 0) {
+            break;
+        }
+        started++;
+    }
+    // Run on the calling thread if no worker could be started
+    if (started == 0) {
+        taskWorker(&pool);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+}
+
+void runSimulationTask(void* arg) {
+    runSimulation(arg);
+}
+
+// Run all simulations on up to `threads` worker threads
+void runSimulations(SimRun* runs, int count, int threads) {
+    runTasks(runs, sizeof(SimRun), count, runSimulationTask, threads);
+}
+
+// Number of worker threads to use, one per online core
+int defaultThreadCount(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+// Percentile lines of one per-burst metric for each class, skipped when no burst completed
+void writeLatencyPercentiles(FILE* fp, const char* metric, const Distribution d[2]) {
+    Distribution overall;
+    memset(&overall, 0, sizeof(overall));
+    mergeDistribution(&overall, d);
+    mergeDistribution(&overall, d + 1);
+    if (overall.stat.count == 0) {
+        return;
+    }
+    const char* classes[3] = {"CPU-bound", "I/O-bound", "overall"};
+    const Distribution* dists[3] = {d, d + 1, &overall};
+    for (int c = 0; c < 3; c++) {
+        const Histogram* h = &dists[c]->hist;
+        fprintf(fp, "-- %s %s percentiles: p50 %dms; p95 %dms; p99 %dms; p99.9 %dms\n", classes[c], metric,
+            histPercentile(h, 0.5), histPercentile(h, 0.95), histPercentile(h, 0.99), histPercentile(h, 0.999));
+    }
+}
+
+// Percentage of the bursts with a deadline that missed it
+double missRate(int misses, int bursts) {
+    return bursts > 0 ? 100.0 * misses / bursts : 0.0;
+}
+
+// Write the simout section of one algorithm
+void writeAlgorithmStats(FILE* fp, const SimRun* run) {
+    const SimMetrics* m = &run->metrics;
+    fprintf(fp, "Algorithm %s\n", algorithmName(run->algorithm));
+    fprintf(fp, "-- CPU utilization: %.3f%%\n", ceil3(m->utilization));
+    fprintf(fp, "-- CPU-bound average wait time: %.3f ms\n", ceil3(m->cpuWait));
+    fprintf(fp, "-- I/O-bound average wait time: %.3f ms\n", ceil3(m->ioWait));
+    fprintf(fp, "-- overall average wait time: %.3f ms\n", ceil3(m->wait));
+    fprintf(fp, "-- CPU-bound average turnaround time: %.3f ms\n", ceil3(m->cpuTurnaround));
+    fprintf(fp, "-- I/O-bound average turnaround time: %.3f ms\n", ceil3(m->ioTurnaround));
+    fprintf(fp, "-- overall average turnaround time: %.3f ms\n", ceil3(m->turnaround));
+    fprintf(fp, "-- CPU-bound number of context switches: %d\n", m->cpuCs);
+    fprintf(fp, "-- I/O-bound number of context switches: %d\n", m->ioCs);
+    fprintf(fp, "-- overall number of context switches: %d\n", m->cpuCs + m->ioCs);
+    fprintf(fp, "-- CPU-bound number of preemptions: %d\n", m->cpuPreemptions);
+    fprintf(fp, "-- I/O-bound number of preemptions: %d\n", m->ioPreemptions);
+    fprintf(fp, "-- overall number of preemptions: %d\n", m->cpuPreemptions + m->ioPreemptions);
+    fprintf(fp, "-- fairness (Jain's index): %.3f\n", ceil3(m->fairness));
+    if (run->algorithm == ALG_RR) {
+        fprintf(fp, "-- CPU-bound percentage of CPU bursts completed within one time slice: %.3f%%\n", ceil3(m->cpuOneTS));
+        fprintf(fp, "-- I/O-bound percentage of CPU bursts completed within one time slice: %.3f%%\n", ceil3(m->ioOneTS));
+        fprintf(fp, "-- overall percentage of CPU bursts completed within one time slice: %.3f%%\n", ceil3(m->oneTS));
+    }
+    if (usesTickets(run->algorithm)) {
+        fprintf(fp, "-- CPU-bound entitled CPU share: %.3f%%\n", ceil3(m->cpuEntitled));
+        fprintf(fp, "-- CPU-bound achieved CPU share: %.3f%%\n", ceil3(m->cpuShare));
+        fprintf(fp, "-- I/O-bound entitled CPU share: %.3f%%\n", ceil3(m->ioEntitled));
+        fprintf(fp, "-- I/O-bound achieved CPU share: %.3f%%\n", ceil3(m->ioShare));
+    }
+    if (m->cpuDeadlines + m->ioDeadlines > 0) {
+        fprintf(fp, "-- CPU-bound deadline miss rate: %.3f%%\n", ceil3(missRate(m->cpuMisses, m->cpuDeadlines)));
+        fprintf(fp, "-- I/O-bound deadline miss rate: %.3f%%\n", ceil3(missRate(m->ioMisses, m->ioDeadlines)));
+        fprintf(fp, "-- overall deadline miss rate: %.3f%%\n",
+            ceil3(missRate(m->cpuMisses + m->ioMisses, m->cpuDeadlines + m->ioDeadlines)));
+    }
+    if (run->cores > 1) {
+        const CoreStats* cs = &run->coreStats;
+        long totalBusy = 0;
+        long maxBusy = 0;
+        fprintf(fp, "-- number of CPUs: %d\n", cs->cores);
+        for (int c = 0; c < cs->cores; c++) {
+            fprintf(fp, "-- CPU %d utilization: %.3f%%\n", c, ceil3(100.0 * cs->busy[c] / run->endTime));
+            totalBusy += cs->busy[c];
+            if (cs->busy[c] > maxBusy) {
+                maxBusy = cs->busy[c];
+            }
+        }
+        // How much longer the busiest CPU ran than the average CPU
+        double meanBusy = (double)totalBusy / cs->cores;
+        fprintf(fp, "-- number of migrations: %d\n", cs->migrations);
+        fprintf(fp, "-- number of work steals: %d\n", cs->steals);
+        fprintf(fp, "-- load imbalance: %.3f%%\n", meanBusy > 0 ? ceil3(100.0 * (maxBusy / meanBusy - 1)) : 0.0);
+    }
+    if (run->latency != NULL) {
+        writeLatencyPercentiles(fp, "wait time", run->latency->wait);
+        writeLatencyPercentiles(fp, "turnaround time", run->latency->turnaround);
+        writeLatencyPercentiles(fp, "lateness", run->latency->lateness);
+    }
+}
+
+// Write the workload summary and every algorithm's section to simout
+void writeSimout(FILE* fp, const Workload* w, const SimRun* runs, int count) {
+    // Write general simulation statistics
+    fprintf(fp, "-- number of processes: %d\n", w->n);
+    fprintf(fp, "-- number of CPU-bound processes: %d\n", w->ncpu);
+    fprintf(fp, "-- number of I/O-bound processes: %d\n", w->n-w->ncpu);
+    fprintf(fp, "-- CPU-bound average CPU burst time: %.3f ms\n", ceil3(w->cpuBoundBurst/w->numCpuBurst) );
+    fprintf(fp, "-- I/O-bound average CPU burst time: %.3f ms\n", ceil3(w->ioBoundBurst/w->numIoBurst) );
+    fprintf(fp, "-- overall average CPU burst time: %.3f ms\n",  ceil3( (w->cpuBoundBurst + w->ioBoundBurst)/(w->numCpuBurst+w->numIoBurst)) );
+    fprintf(fp, "-- CPU-bound average I/O burst time: %.3f ms\n", ceil3(w->cpuIOBurst/w->numCpuIOBurst) );
+    fprintf(fp, "-- I/O-bound average I/O burst time: %.3f ms\n", ceil3(w->ioIOBurst/w->numIoIOBurst) );
+    fprintf(fp, "-- overall average I/O burst time: %.3f ms\n\n", ceil3( (w->cpuIOBurst + w->ioIOBurst)/(w->numCpuIOBurst+w->numIoIOBurst)) );
+    // Sections are separated by a blank line
+    for (int k = 0; k < count; k++) {
+        if (k > 0) {
+            fprintf(fp, "\n");
+        }
+        writeAlgorithmStats(fp, runs + k);
+    }
+}
+
+// Write the per-burst distributions of every run to path as CSV, one row per algorithm, metric and class
+// Returns false on failure
+bool writeLatencyCsv(const char* path, const SimRun* runs, int count) {
+    FILE* fp = fopen(path, "w");
+    if (fp == NULL) {
+        perror("ERROR: fopen() failed");
+        return false;
+    }
+    fprintf(fp, "algorithm,metric,class,count,mean,stddev,min,max,p50,p95,p99,p999\n");
+    const char* metrics[3] = {"wait", "turnaround", "lateness"};
+    const char* classes[3] = {"cpu", "io", "all"};
+    for (int k = 0; k < count; k++) {
+        if (runs[k].latency == NULL) continue;
+        for (int m = 0; m < 3; m++) {
+            const Distribution* d = m == 0 ? runs[k].latency->wait : m == 1 ? runs[k].latency->turnaround : runs[k].latency->lateness;
+            Distribution overall;
+            memset(&overall, 0, sizeof(overall));
+            mergeDistribution(&overall, d);
+            mergeDistribution(&overall, d + 1);
+            const Distribution* dists[3] = {d, d + 1, &overall};
+            for (int c = 0; c < 3; c++) {
+                const RunningStat* s = &dists[c]->stat;
+                const Histogram* h = &dists[c]->hist;
+                if (s->count == 0) continue;
+                fprintf(fp, "%s,%s,%s,%ld,%.3f,%.3f,%d,%d,%d,%d,%d,%d\n", algorithmName(runs[k].algorithm), metrics[m], classes[c],
+                    s->count, s->mean, statStddev(s), h->min, h->max,
+                    histPercentile(h, 0.5), histPercentile(h, 0.95), histPercentile(h, 0.99), histPercentile(h, 0.999));
+            }
+        }
+    }
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "ERROR: Failed to write %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+#ifdef STATS
+// Write the --stats summary: the time of each phase and the hot path counters of every run
+void printStats(FILE* out, const SimRun* runs, int count, double generation, double output) {
+    double simulation = 0.0;
+    for (int k = 0; k < count; k++) {
+        simulation += runs[k].stats.seconds;
+    }
+    fprintf(out, "<<< STATS\n");
+    fprintf(out, "<<< -- generation %.6fs; simulations %.6fs; output %.6fs\n", generation, simulation, output);
+    for (int k = 0; k < count; k++) {
+        const SimStats* s = &runs[k].stats;
+        long events = 0;
+        for (int st = 0; st <= TERMINATED; st++) {
+            events += s->eventsByState[st];
+        }
+        fprintf(out, "Algorithm %s: %.6fs\n", algorithmName(runs[k].algorithm), s->seconds);
+        fprintf(out, "-- events: %ld;", events);
+        for (int st = 0; st <= TERMINATED; st++) {
+            if (s->eventsByState[st] > 0) {
+                fprintf(out, " %s %ld", stateToString(st), s->eventsByState[st]);
+            }
+        }
+        fprintf(out, "\n");
+        fprintf(out, "-- event queue: %ld comparisons; %ld shifts; max depth %d\n", s->eventComparisons, s->eventShifts, s->maxEvents);
+        fprintf(out, "-- ready queue: %ld comparisons; %ld shifts; max depth %d\n", s->readyComparisons, s->readyShifts, s->maxReady);
+    }
+}
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------------
+// Structured export
+// One record per simulation with its parameters and simout metrics, and optionally one per process,
+// written straight from the finished runs. Paths ending in .json get JSON, anything else CSV.
+
+bool isJsonPath(const char* path) {
+    size_t len = strlen(path);
+    return len >= 5 && strcmp(path + len - 5, ".json") == 0;
+}
+
+// JSON has no NaN or infinity, metrics of an empty class are written as null
+void writeJsonNumber(FILE* fp, double value) {
+    if (isfinite(value)) {
+        fprintf(fp, "%.3f", value);
+    } else {
+        fprintf(fp, "null");
+    }
+}
+
+void writeJsonString(FILE* fp, const char* s) {
+    fputc('"', fp);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            fprintf(fp, "\\%c", *s);
+        } else if ((unsigned char)*s < 0x20) {
+            fprintf(fp, "\\u%04x", *s);
+        } else {
+            fputc(*s, fp);
+        }
+    }
+    fputc('"', fp);
+}
+
+// Quote a CSV field if it contains a separator, quote or newline
+void writeCsvString(FILE* fp, const char* s) {
+    if (strpbrk(s, ",\"\n\r") == NULL) {
+        fputs(s, fp);
+        return;
+    }
+    fputc('"', fp);
+    for (; *s; s++) {
+        if (*s == '"') fputc('"', fp);
+        fputc(*s, fp);
+    }
+    fputc('"', fp);
+}
+
+// Parameters shared by the run and per-process records
+void writeJsonRunParams(FILE* fp, int index, const SimRun* run) {
+    const Workload* w = run->workload;
+    fprintf(fp, "\"run\": %d, \"algorithm\": \"%s\", \"n\": %d, \"ncpu\": %d, \"seed\": %d, \"lambda\": %.6f, \"bound\": %d, \"tcs\": %d, ",
+        index, algorithmName(run->algorithm), w->n, w->ncpu, w->seed, w->lambda, w->upperBound, run->tcs);
+    if (usesAlpha(run->algorithm)) {
+        fprintf(fp, "\"alpha\": %.2f, ", run->alpha);
+    } else {
+        fprintf(fp, "\"alpha\": null, ");
+    }
+    if (usesTimeSlice(run->algorithm)) {
+        fprintf(fp, "\"tslice\": %d, ", run->tslice);
+    } else {
+        fprintf(fp, "\"tslice\": null, ");
+    }
+    fprintf(fp, "\"cpus\": %d", run->cores > 1 ? run->cores : 1);
+}
+
+void writeCsvRunParams(FILE* fp, int index, const SimRun* run) {
+    const Workload* w = run->workload;
+    fprintf(fp, "%d,%s,%d,%d,%d,%.6f,%d,%d,", index, algorithmName(run->algorithm), w->n, w->ncpu, w->seed, w->lambda, w->upperBound, run->tcs);
+    if (usesAlpha(run->algorithm)) {
+        fprintf(fp, "%.2f", run->alpha);
+    }
+    fprintf(fp, ",");
+    if (usesTimeSlice(run->algorithm)) {
+        fprintf(fp, "%d", run->tslice);
+    }
+    fprintf(fp, ",%d", run->cores > 1 ? run->cores : 1);
+}
+
+#define CSV_RUN_PARAMS "run,algorithm,n,ncpu,seed,lambda,bound,tcs,alpha,tslice,cpus"
+
+// Metrics simout only prints for some runs: deadline miss rates when bursts had deadlines, CPU shares for
+// ticket policies and overall latency percentiles when the run kept its distributions (the main run does,
+// sweeps do not). The others are NAN, written as null in JSON and an empty field in CSV.
+#define EXPORT_OPTIONAL_METRICS 19
+
+const char* exportOptionalNames[EXPORT_OPTIONAL_METRICS] = {
+    "cpu_miss_rate", "io_miss_rate", "miss_rate",
+    "cpu_entitled_share", "cpu_achieved_share", "io_entitled_share", "io_achieved_share",
+    "wait_p50", "wait_p95", "wait_p99", "wait_p999",
+    "turnaround_p50", "turnaround_p95", "turnaround_p99", "turnaround_p999",
+    "lateness_p50", "lateness_p95", "lateness_p99", "lateness_p999"
+};
+
+void exportOptionalValues(const SimRun* run, double* values) {
+    const SimMetrics* m = &run->metrics;
+    for (int v = 0; v < EXPORT_OPTIONAL_METRICS; v++) {
+        values[v] = NAN;
+    }
+    if (m->cpuDeadlines > 0) {
+        values[0] = missRate(m->cpuMisses, m->cpuDeadlines);
+    }
+    if (m->ioDeadlines > 0) {
+        values[1] = missRate(m->ioMisses, m->ioDeadlines);
+    }
+    if (m->cpuDeadlines + m->ioDeadlines > 0) {
+        values[2] = missRate(m->cpuMisses + m->ioMisses, m->cpuDeadlines + m->ioDeadlines);
+    }
+    if (usesTickets(run->algorithm)) {
+        values[3] = m->cpuEntitled;
+        values[4] = m->cpuShare;
+        values[5] = m->ioEntitled;
+        values[6] = m->ioShare;
+    }
+    if (run->latency != NULL) {
+        const Distribution* dists[3] = {run->latency->wait, run->latency->turnaround, run->latency->lateness};
+        const double quantiles[4] = {0.5, 0.95, 0.99, 0.999};
+        for (int d = 0; d < 3; d++) {
+            Distribution overall;
+            memset(&overall, 0, sizeof(overall));
+            mergeDistribution(&overall, dists[d]);
+            mergeDistribution(&overall, dists[d] + 1);
+            if (overall.stat.count == 0) continue;
+            for (int q = 0; q < 4; q++) {
+                values[7 + 4 * d + q] = histPercentile(&overall.hist, quantiles[q]);
+            }
+        }
+    }
+}
+
+void writeRunsJson(FILE* fp, const SimRun* runs, int count) {
+    fprintf(fp, "[\n");
+    for (int r = 0; r < count; r++) {
+        const SimMetrics* m = &runs[r].metrics;
+        fprintf(fp, "  {");
+        writeJsonRunParams(fp, r, runs + r);
+        fprintf(fp, ", \"end_time\": %d, \"utilization\": ", runs[r].endTime);
+        writeJsonNumber(fp, m->utilization);
+        double values[10] = {m->cpuWait, m->ioWait, m->wait, m->cpuTurnaround, m->ioTurnaround, m->turnaround,
+                             m->cpuOneTS, m->ioOneTS, m->oneTS, m->fairness};
+        const char* names[10] = {"cpu_wait", "io_wait", "wait", "cpu_turnaround", "io_turnaround", "turnaround",
+                                 "cpu_one_ts", "io_one_ts", "one_ts", "fairness"};
+        for (int v = 0; v < 10; v++) {
+            fprintf(fp, ", \"%s\": ", names[v]);
+            writeJsonNumber(fp, values[v]);
+        }
+        fprintf(fp, ", \"cpu_cs\": %d, \"io_cs\": %d, \"cs\": %d, \"cpu_preemptions\": %d, \"io_preemptions\": %d, \"preemptions\": %d",
+            m->cpuCs, m->ioCs, m->cpuCs + m->ioCs, m->cpuPreemptions, m->ioPreemptions, m->cpuPreemptions + m->ioPreemptions);
+        double optional[EXPORT_OPTIONAL_METRICS];
+        exportOptionalValues(runs + r, optional);
+        for (int v = 0; v < EXPORT_OPTIONAL_METRICS; v++) {
+            fprintf(fp, ", \"%s\": ", exportOptionalNames[v]);
+            writeJsonNumber(fp, optional[v]);
+        }
+        fprintf(fp, "}%s\n", r + 1 < count ? "," : "");
+    }
+    fprintf(fp, "]\n");
+}
+
+void writeRunsCsv(FILE* fp, const SimRun* runs, int count) {
+    fprintf(fp, CSV_RUN_PARAMS ",end_time,utilization,cpu_wait,io_wait,wait,cpu_turnaround,io_turnaround,turnaround,"
+                "cpu_one_ts,io_one_ts,one_ts,fairness,cpu_cs,io_cs,cs,cpu_preemptions,io_preemptions,preemptions");
+    for (int v = 0; v < EXPORT_OPTIONAL_METRICS; v++) {
+        fprintf(fp, ",%s", exportOptionalNames[v]);
+    }
+    fprintf(fp, "\n");
+    for (int r = 0; r < count; r++) {
+        const SimMetrics* m = &runs[r].metrics;
+        writeCsvRunParams(fp, r, runs + r);
+        fprintf(fp, ",%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%d,%d,%d,%d,%d", runs[r].endTime, m->utilization,
+            m->cpuWait, m->ioWait, m->wait, m->cpuTurnaround, m->ioTurnaround, m->turnaround, m->cpuOneTS, m->ioOneTS, m->oneTS, m->fairness,
+            m->cpuCs, m->ioCs, m->cpuCs + m->ioCs, m->cpuPreemptions, m->ioPreemptions, m->cpuPreemptions + m->ioPreemptions);
+        double optional[EXPORT_OPTIONAL_METRICS];
+        exportOptionalValues(runs + r, optional);
+        for (int v = 0; v < EXPORT_OPTIONAL_METRICS; v++) {
+            if (isfinite(optional[v])) {
+                fprintf(fp, ",%.3f", optional[v]);
+            } else {
+                fprintf(fp, ",");
+            }
+        }
+        fprintf(fp, "\n");
+    }
+}
+
+// Per-process records of every run that kept them
+void writeProcessesJson(FILE* fp, const SimRun* runs, int count) {
+    fprintf(fp, "[\n");
+    bool first = true;
+    for (int r = 0; r < count; r++) {
+        const Workload* w = runs[r].workload;
+        for (int i = 0; runs[r].processes != NULL && i < w->n; i++) {
+            const ProcessResult* p = runs[r].processes + i;
+            fprintf(fp, "%s  {", first ? "" : ",\n");
+            first = false;
+            writeJsonRunParams(fp, r, runs + r);
+            fprintf(fp, ", \"pid\": ");
+            writeJsonString(fp, pidName(w->processes + i));
+            fprintf(fp, ", \"class\": \"%s\", \"bursts\": %d, \"wait\": %d, \"turnaround\": %d, \"cs\": %d, \"preemptions\": %d"
+                ", \"deadline_bursts\": %d, \"deadline_misses\": %d}",
+                i < w->ncpu ? "cpu" : "io", w->processes[i].numBursts, p->wait, p->turnaround, p->cs, p->preemptions,
+                p->deadlineBursts, p->deadlineMisses);
+        }
+    }
+    fprintf(fp, "%s]\n", first ? "" : "\n");
+}
+
+void writeProcessesCsv(FILE* fp, const SimRun* runs, int count) {
+    fprintf(fp, CSV_RUN_PARAMS ",pid,class,bursts,wait,turnaround,cs,preemptions,deadline_bursts,deadline_misses\n");
+    for (int r = 0; r < count; r++) {
+        const Workload* w = runs[r].workload;
+        for (int i = 0; runs[r].processes != NULL && i < w->n; i++) {
+            const ProcessResult* p = runs[r].processes + i;
+            writeCsvRunParams(fp, r, runs + r);
+            fputc(',', fp);
+            writeCsvString(fp, pidName(w->processes + i));
+            fprintf(fp, ",%s,%d,%d,%d,%d,%d,%d,%d\n", i < w->ncpu ? "cpu" : "io", w->processes[i].numBursts,
+                p->wait, p->turnaround, p->cs, p->preemptions, p->deadlineBursts, p->deadlineMisses);
+        }
+    }
+}
+
+// Write the run records, or the per-process records, to path; returns false on failure
+bool writeExport(const char* path, const SimRun* runs, int count, bool perProcess) {
+    FILE* fp = fopen(path, "w");
+    if (fp == NULL) {
+        perror("ERROR: fopen() failed");
+        return false;
+    }
+    bool json = isJsonPath(path);
+    if (perProcess && json) {
+        writeProcessesJson(fp, runs, count);
+    } else if (perProcess) {
+        writeProcessesCsv(fp, runs, count);
+    } else if (json) {
+        writeRunsJson(fp, runs, count);
+    } else {
+        writeRunsCsv(fp, runs, count);
+    }
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "ERROR: Failed to write %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------
+// Argument checks
+// Shared by the main run, --sweep and --batch; each prints the error and returns false for an invalid value
+
+bool validProcessCounts(int n, int ncpu) {
+    if (n < 1) {
+        fprintf(stderr, "ERROR: Number of processes < 1\n");
+        return false;
+    }
+    if (ncpu < 0 || ncpu > n) {
+        fprintf(stderr, "ERROR: Number of CPU-bound processes is not in the range 0 to %d\n", n);
+        return false;
+    }
+    return true;
+}
+
+bool validLambda(double lambda) {
+    if (lambda <= 0) {
+        fprintf(stderr, "ERROR: Lambda <= 0\n");
+        return false;
+    }
+    return true;
+}
+
+bool validContextSwitch(int tcs) {
+    if (tcs < 0) {
+        fprintf(stderr, "ERROR: Negative context switch\n");
+        return false;
+    }
+    return true;
+}
+
+bool validAlpha(double alpha) {
+    if (alpha > 1 || alpha < 0) {
+        fprintf(stderr, "ERROR: Alpha is not in the range 0 to 1\n");
+        return false;
+    }
+    return true;
+}
+
+bool validTimeSlice(int tslice) {
+    if (tslice < 0) {
+        fprintf(stderr, "ERROR: Negative timeslice\n");
+        return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------
+// Parameter sweep
+
+// Parse a comma separated list of values and start:end:step ranges, e.g. "2,4,8" or "0.1:0.9:0.2"
+// Returns the number of values, or -1 if the list is invalid
+int parseList(const char* spec, double** values) {
+    int count = 0;
+    int capacity = 8;
+    *values = calloc(capacity, sizeof(double));
+    const char* cur = spec;
+    while (*cur != '\0') {
+        char* end;
+        double start = strtod(cur, &end);
+        if (end == cur) {
+            free(*values);
+            *values = NULL;
+            return -1;
+        }
+        double stop = start;
+        double step = 1;
+        if (*end == ':') {
+            cur = end + 1;
+            stop = strtod(cur, &end);
+            if (*end == ':') {
+                cur = end + 1;
+                step = strtod(cur, &end);
+            }
+            if (step <= 0) {
+                free(*values);
+                *values = NULL;
+                return -1;
+            }
+        }
+        // Small tolerance so fractional steps reach the end of the range
+        for (double v = start; v <= stop + step * 1e-9; v += step) {
+            if (count == capacity) {
+                capacity *= 2;
+                *values = realloc(*values, capacity * sizeof(double));
+            }
+            (*values)[count++] = v;
+        }
+        if (*end == ',') {
+            end++;
+        } else if (*end != '\0') {
+            free(*values);
+            *values = NULL;
+            return -1;
+        }
+        cur = end;
+    }
+    return count;
+}
+
+// Sweep every algorithm over lists of the main arguments and write one table of their metrics
+// Usage: --sweep <n> <ncpu> <seeds> <lambdas> <bounds> <t_cs list> <alphas> <t_slice list>
+// --deadlines gives the workloads burst deadlines, adds EDF and a deadline miss rate column
+int runSweep(int argc, char** argv) {
+    if (argc < 10){
+        fprintf(stderr, "ERROR: Invalid argument(s)\n");
+        fprintf(stderr, "USAGE: %s --sweep <n> <ncpu> <seeds> <lambdas> <bounds> <t_cs list> <alphas> <t_slice list>"
+            " [--deadlines] [--export FILE] [--export-processes FILE]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char* exportPath = NULL;
+    const char* processExportPath = NULL;
+    bool deadlines = false;
+    for (int i = 10; i < argc; i++) {
+        if (strcmp(argv[i], "--deadlines") == 0) {
+            deadlines = true;
+        } else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+            exportPath = argv[++i];
+        } else if (strcmp(argv[i], "--export-processes") == 0 && i + 1 < argc) {
+            processExportPath = argv[++i];
+        } else {
+            fprintf(stderr, "ERROR: Unknown option %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+    int n = atoi(argv[2]);
+    int ncpu = atoi(argv[3]);
+    if (!validProcessCounts(n, ncpu)) {
+        return EXIT_FAILURE;
+    }
+    double* lists[6];
+    int counts[6];
+    const char* names[6] = {"seeds", "lambdas", "bounds", "t_cs", "alphas", "t_slice"};
+    for (int k = 0; k < 6; k++) {
+        counts[k] = parseList(argv[4 + k], &lists[k]);
+        if (counts[k] <= 0) {
+            fprintf(stderr, "ERROR: Invalid list of %s: %s\n", names[k], argv[4 + k]);
+            return EXIT_FAILURE;
+        }
+    }
+    double *seeds = lists[0], *lambdas = lists[1], *bounds = lists[2];
+    double *tcsList = lists[3], *alphas = lists[4], *tslices = lists[5];
+    for (int i = 0; i < counts[1]; i++) {
+        if (!validLambda(lambdas[i])) return EXIT_FAILURE;
+    }
+    for (int i = 0; i < counts[3]; i++) {
+        if (!validContextSwitch((int)tcsList[i])) return EXIT_FAILURE;
+    }
+    for (int i = 0; i < counts[4]; i++) {
+        if (!validAlpha(alphas[i])) return EXIT_FAILURE;
+    }
+    for (int i = 0; i < counts[5]; i++) {
+        if (!validTimeSlice((int)tslices[i])) return EXIT_FAILURE;
+    }
+
+    // Generate each workload once; it is shared by every point that uses it
+    int numWorkloads = counts[0] * counts[1] * counts[2];
+    Workload* workloads = calloc(numWorkloads, sizeof(Workload));
+    int wi = 0;
+    for (int s = 0; s < counts[0]; s++) {
+        for (int l = 0; l < counts[1]; l++) {
+            for (int b = 0; b < counts[2]; b++) {
+                generateWorkload(workloads + wi++, n, ncpu, (int)seeds[s], lambdas[l], (int)bounds[b], deadlines);
+            }
+        }
+    }
+
+    // Only fan out the parameters each algorithm depends on
+    // FCFS/EDF: t_cs, SJF/SRT: t_cs and alpha, RR/CFS/MLFQ/STRIDE/LOTTERY: t_cs and t_slice
+    int perWorkload = counts[3] * ((deadlines ? 2 : 1) + 2 * counts[4] + 5 * counts[5]);
+    int numRuns = numWorkloads * perWorkload;
+    SimRun* runs = calloc(numRuns, sizeof(SimRun));
+    int ri = 0;
+    for (int w = 0; w < numWorkloads; w++) {
+        for (int c = 0; c < counts[3]; c++) {
+            int tcs = (int)tcsList[c];
+            runs[ri++] = (SimRun){.algorithm = ALG_FCFS, .workload = workloads + w, .tcs = tcs};
+            if (deadlines) {
+                runs[ri++] = (SimRun){.algorithm = ALG_EDF, .workload = workloads + w, .tcs = tcs};
+            }
+            for (int a = 0; a < counts[4]; a++) {
+                runs[ri++] = (SimRun){.algorithm = ALG_SJF, .workload = workloads + w, .tcs = tcs, .alpha = alphas[a]};
+            }
+            for (int a = 0; a < counts[4]; a++) {
+                runs[ri++] = (SimRun){.algorithm = ALG_SRT, .workload = workloads + w, .tcs = tcs, .alpha = alphas[a]};
+            }
+            for (int t = 0; t < counts[5]; t++) {
+                runs[ri++] = (SimRun){.algorithm = ALG_RR, .workload = workloads + w, .tcs = tcs, .tslice = (int)tslices[t]};
+            }
+            for (int t = 0; t < counts[5]; t++) {
+                runs[ri++] = (SimRun){.algorithm = ALG_CFS, .workload = workloads + w, .tcs = tcs, .tslice = (int)tslices[t]};
+            }
+            for (int t = 0; t < counts[5]; t++) {
+                runs[ri++] = (SimRun){.algorithm = ALG_MLFQ, .workload = workloads + w, .tcs = tcs, .tslice = (int)tslices[t]};
+            }
+            for (int t = 0; t < counts[5]; t++) {
+                runs[ri++] = (SimRun){.algorithm = ALG_STRIDE, .workload = workloads + w, .tcs = tcs, .tslice = (int)tslices[t]};
+            }
+            for (int t = 0; t < counts[5]; t++) {
+                runs[ri++] = (SimRun){.algorithm = ALG_LOTTERY, .workload = workloads + w, .tcs = tcs, .tslice = (int)tslices[t]};
+            }
+        }
+    }
+    for (int r = 0; r < numRuns; r++) {
+        runs[r].keepProcesses = processExportPath != NULL;
+    }
+    runSimulations(runs, numRuns, defaultThreadCount());
+
+    FILE *fp = fopen("sweep.txt", "w");
+    if (fp == NULL) {
+        perror("Error opening file");
+        return EXIT_FAILURE;
+    }
+    fprintf(fp, "# n=%d; ncpu=%d; %d workloads; %d simulations\n", n, ncpu, numWorkloads, numRuns);
+    fprintf(fp, "%-8s %-10s %-6s %-7s %-5s %-5s %-7s %-9s %-10s %-10s %-10s %-10s %-10s %-10s %-6s %-6s %-6s %-6s %-6s %-6s %-6s",
+        "seed", "lambda", "bound", "alg", "t_cs", "alpha", "t_slice", "util%",
+        "cpu_wait", "io_wait", "wait", "cpu_tat", "io_tat", "tat",
+        "cpu_cs", "io_cs", "cs", "cpu_pr", "io_pr", "pr", "jain");
+    if (deadlines) {
+        fprintf(fp, " %-7s", "miss%");
+    }
+    fprintf(fp, "\n");
+    for (int r = 0; r < numRuns; r++) {
+        const SimRun* run = runs + r;
+        const SimMetrics* m = &run->metrics;
+        char alpha[16] = "-";
+        char tslice[16] = "-";
+        if (usesAlpha(run->algorithm)) {
+            snprintf(alpha, sizeof(alpha), "%.2f", run->alpha);
+        }
+        if (usesTimeSlice(run->algorithm)) {
+            snprintf(tslice, sizeof(tslice), "%d", run->tslice);
+        }
+        fprintf(fp, "%-8d %-10.6f %-6d %-7s %-5d %-5s %-7s %-9.3f %-10.3f %-10.3f %-10.3f %-10.3f %-10.3f %-10.3f %-6d %-6d %-6d %-6d %-6d %-6d %-6.3f",
+            run->workload->seed, run->workload->lambda, run->workload->upperBound,
+            algorithmName(run->algorithm), run->tcs, alpha, tslice, ceil3(m->utilization),
+            ceil3(m->cpuWait), ceil3(m->ioWait), ceil3(m->wait),
+            ceil3(m->cpuTurnaround), ceil3(m->ioTurnaround), ceil3(m->turnaround),
+            m->cpuCs, m->ioCs, m->cpuCs + m->ioCs,
+            m->cpuPreemptions, m->ioPreemptions, m->cpuPreemptions + m->ioPreemptions, ceil3(m->fairness));
+        if (deadlines) {
+            fprintf(fp, " %-7.3f", ceil3(missRate(m->cpuMisses + m->ioMisses, m->cpuDeadlines + m->ioDeadlines)));
+        }
+        fprintf(fp, "\n");
+    }
+    fclose(fp);
+    printf("<<< -- sweep of %d simulations over %d workloads written to sweep.txt\n", numRuns, numWorkloads);
+    bool exported = true;
+    if (exportPath != NULL) {
+        exported = writeExport(exportPath, runs, numRuns, false);
+    }
+    if (processExportPath != NULL && exported) {
+        exported = writeExport(processExportPath, runs, numRuns, true);
+    }
+
+    // Clean up
+    for (int r = 0; r < numRuns; r++) {
+        freeSimRun(runs + r);
+    }
+    free(runs);
+    for (int w = 0; w < numWorkloads; w++) {
+        freeWorkload(workloads + w);
+    }
+    free(workloads);
+    for (int k = 0; k < 6; k++) {
+        free(lists[k]);
+    }
+    return exported ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------
+// Multi-seed batch runs
+
+// Half-width of the 95% confidence interval of the mean, using Student's t for small samples
+double statCI95(const RunningStat* s) {
+    static const double t[] = {0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                               2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                               2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (s->count < 2) return 0.0;
+    long df = s->count - 1;
+    double tValue;
+    if (df <= 30) {
+        tValue = t[df];
+    } else if (df < 60) {
+        tValue = 2.021;
+    } else if (df < 120) {
+        tValue = 2.000;
+    } else {
+        tValue = 1.960;
+    }
+    return tValue * statStddev(s) / sqrt((double)s->count);
+}
+
+// Metrics aggregated over seeds, in report order
+#define BATCH_METRICS 14
+#define MIN_BATCH_SEEDS 5
+
+const char* batchMetricNames[BATCH_METRICS] = {
+    "CPU utilization",
+    "CPU-bound average wait time", "I/O-bound average wait time", "overall average wait time",
+    "CPU-bound average turnaround time", "I/O-bound average turnaround time", "overall average turnaround time",
+    "CPU-bound number of context switches", "I/O-bound number of context switches", "overall number of context switches",
+    "CPU-bound number of preemptions", "I/O-bound number of preemptions", "overall number of preemptions",
+    "fairness (Jain's index)"
+};
+const char* batchMetricUnits[BATCH_METRICS] = {"%", " ms", " ms", " ms", " ms", " ms", " ms", "", "", "", "", "", "", ""};
+
+void batchMetricValues(const SimMetrics* m, double* values) {
+    values[0] = m->utilization;
+    values[1] = m->cpuWait;
+    values[2] = m->ioWait;
+    values[3] = m->wait;
+    values[4] = m->cpuTurnaround;
+    values[5] = m->ioTurnaround;
+    values[6] = m->turnaround;
+    values[7] = m->cpuCs;
+    values[8] = m->ioCs;
+    values[9] = m->cpuCs + m->ioCs;
+    values[10] = m->cpuPreemptions;
+    values[11] = m->ioPreemptions;
+    values[12] = m->cpuPreemptions + m->ioPreemptions;
+    values[13] = m->fairness;
+}
+
+// One seed of a batch: its workload is generated and simulated by every algorithm on a worker thread
+typedef struct {
+    int n;
+    int ncpu;
+    int seed;
+    double lambda;
+    int upperBound;
+    int tcs;
+    double alpha;
+    int tslice;
+    bool deadlines;
+    SimMetrics metrics[ALG_COUNT];
+} BatchJob;
+
+void runBatchJob(void* arg) {
+    BatchJob* job = arg;
+    Workload workload;
+    generateWorkload(&workload, job->n, job->ncpu, job->seed, job->lambda, job->upperBound, job->deadlines);
+    for (int k = 0; k < ALG_COUNT; k++) {
+        if (needsDeadlines(k) && !job->deadlines) continue;
+        SimRun run = {.algorithm = k, .workload = &workload, .tcs = job->tcs, .alpha = job->alpha, .tslice = job->tslice};
+        runSimulation(&run);
+        job->metrics[k] = run.metrics;
+    }
+    freeWorkload(&workload);
+}
+
+// True once the overall wait and turnaround CIs of every algorithm are within target (fraction of the mean)
+bool batchConverged(RunningStat stats[ALG_COUNT][BATCH_METRICS], double target, bool deadlines) {
+    int checked[2] = {3, 6};
+    for (int k = 0; k < ALG_COUNT; k++) {
+        if (needsDeadlines(k) && !deadlines) continue;
+        for (int c = 0; c < 2; c++) {
+            const RunningStat* s = &stats[k][checked[c]];
+            if (statCI95(s) > target * fabs(s->mean)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Run one configuration over consecutive seeds and report mean, stddev and 95% CI of every simout metric
+// Usage: --batch <max seeds> <ci target> <n> <ncpu> <seed> <lambda> <bound> <t_cs> <alpha> <t_slice> [--deadlines]
+// A ci target above 0 stops once every algorithm's overall wait and turnaround CI half-width is within
+// that fraction of the mean (e.g. 0.01 for 1%). --deadlines gives the workloads burst deadlines and adds EDF
+int runBatch(int argc, char** argv) {
+    if (argc < 12 || argc > 13 || (argc == 13 && strcmp(argv[12], "--deadlines") != 0)){
+        fprintf(stderr, "ERROR: Invalid argument(s)\n");
+        fprintf(stderr, "USAGE: %s --batch <max seeds> <ci target> <n> <ncpu> <seed> <lambda> <bound> <t_cs> <alpha> <t_slice>"
+            " [--deadlines]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    int maxSeeds = atoi(argv[2]);
+    double target = atof(argv[3]);
+    BatchJob config = {0};
+    config.n = atoi(argv[4]);
+    config.ncpu = atoi(argv[5]);
+    int firstSeed = atoi(argv[6]);
+    config.lambda = atof(argv[7]);
+    config.upperBound = atoi(argv[8]);
+    config.tcs = atoi(argv[9]);
+    config.alpha = atof(argv[10]);
+    config.tslice = atoi(argv[11]);
+    config.deadlines = argc == 13;
+    if (maxSeeds < 1){
+        fprintf(stderr, "ERROR: Number of seeds < 1\n");
+        return EXIT_FAILURE;
+    }
+    if (!validProcessCounts(config.n, config.ncpu) || !validLambda(config.lambda) || !validContextSwitch(config.tcs)
+        || !validAlpha(config.alpha) || !validTimeSlice(config.tslice)){
+        return EXIT_FAILURE;
+    }
+
+    // Seeds run in waves of one job per thread; results are added in seed order so the
+    // stopping point does not depend on the number of threads
+    int threads = defaultThreadCount();
+    BatchJob* jobs = calloc(threads, sizeof(BatchJob));
+    RunningStat stats[ALG_COUNT][BATCH_METRICS];
+    memset(stats, 0, sizeof(stats));
+    int used = 0;
+    bool converged = false;
+    while (used < maxSeeds && !converged) {
+        int wave = maxSeeds - used < threads ? maxSeeds - used : threads;
+        for (int j = 0; j < wave; j++) {
+            jobs[j] = config;
+            jobs[j].seed = firstSeed + used + j;
+        }
+        runTasks(jobs, sizeof(BatchJob), wave, runBatchJob, threads);
+        for (int j = 0; j < wave && !converged; j++) {
+            for (int k = 0; k < ALG_COUNT; k++) {
+                if (needsDeadlines(k) && !config.deadlines) continue;
+                double values[BATCH_METRICS];
+                batchMetricValues(&jobs[j].metrics[k], values);
+                for (int v = 0; v < BATCH_METRICS; v++) {
+                    addSample(&stats[k][v], values[v]);
+                }
+            }
+            used++;
+            if (target > 0 && used >= MIN_BATCH_SEEDS) {
+                converged = batchConverged(stats, target, config.deadlines);
+            }
+        }
+    }
+    free(jobs);
+
+    FILE *fp = fopen("batch.txt", "w");
+    if (fp == NULL) {
+        perror("Error opening file");
+        return EXIT_FAILURE;
+    }
+    fprintf(fp, "-- number of processes: %d\n", config.n);
+    fprintf(fp, "-- number of CPU-bound processes: %d\n", config.ncpu);
+    fprintf(fp, "-- lambda=%.6f; bound=%d; t_cs=%dms; alpha=%.2f; t_slice=%dms\n",
+        config.lambda, config.upperBound, config.tcs, config.alpha, config.tslice);
+    fprintf(fp, "-- seeds: %d (%d to %d)\n", used, firstSeed, firstSeed + used - 1);
+    if (converged) {
+        fprintf(fp, "-- stopped early: 95%% CI half-width within %.3f%% of the mean\n\n", 100.0 * target);
+    } else {
+        fprintf(fp, "\n");
+    }
+    for (int k = 0; k < ALG_COUNT; k++) {
+        if (needsDeadlines(k) && !config.deadlines) continue;
+        fprintf(fp, "Algorithm %s\n", algorithmName(k));
+        for (int v = 0; v < BATCH_METRICS; v++) {
+            const char* unit = batchMetricUnits[v];
+            fprintf(fp, "-- %s: mean %.3f%s; stddev %.3f%s; 95%% CI +/- %.3f%s\n", batchMetricNames[v],
+                ceil3(stats[k][v].mean), unit, ceil3(statStddev(&stats[k][v])), unit, ceil3(statCI95(&stats[k][v])), unit);
+        }
+        fprintf(fp, "\n");
+    }
+    fclose(fp);
+    printf("<<< -- batch of %d seeds written to batch.txt\n", used);
+    return EXIT_SUCCESS;
+}
+
+// Result of one benchmark case, sent back by the child process that ran it
+typedef struct {
+    long events;
+    long allocations;
+    double seconds;
+} BenchResult;
+
+// Run one simulation without logging in a child process, so its peak RSS is its own
+// Returns false if the child could not be run or did not report
+bool runBenchCase(SimRun* run, BenchResult* result, long* peakRss) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("ERROR: pipe() failed");
+        return false;
+    }
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("ERROR: fork() failed");
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        SimCounters before = simCounters;
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        runSimulation(run);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        BenchResult r = {simCounters.events - before.events, simCounters.allocations - before.allocations,
+            elapsedSeconds(&start, &end)};
+        ssize_t written = write(fds[1], &r, sizeof(r));
+        _exit(written == (ssize_t)sizeof(r) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    close(fds[1]);
+    ssize_t got = read(fds[0], result, sizeof(BenchResult));
+    close(fds[0]);
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        perror("ERROR: wait4() failed");
+        return false;
+    }
+    *peakRss = usage.ru_maxrss;
+    return got == (ssize_t)sizeof(BenchResult) && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+// Benchmark workloads: n runs over powers of ten, one CPU-bound process in ten
+// Times are int milliseconds; at n=100000 the longest run ends near 2.6e8ms, a tenth of INT_MAX,
+// and n=1000000 would overflow them, so larger sizes are rejected
+#define BENCH_MIN_N 10
+#define BENCH_MAX_N 100000
+#define BENCH_SEED 1
+#define BENCH_BOUND 128
+#define BENCH_TCS 2
+#define BENCH_ALPHA 0.5
+
+// Measure simulator throughput on generated workloads and write it to bench_output.txt
+// Usage: --bench [max n]
+// Every algorithm runs once per (n, lambda), and once per t_slice if it uses one
+int runBench(int argc, char** argv) {
+    int maxN = argc > 2 ? atoi(argv[2]) : BENCH_MAX_N;
+    if (maxN < BENCH_MIN_N || maxN > BENCH_MAX_N){
+        fprintf(stderr, "ERROR: Invalid argument(s)\n");
+        fprintf(stderr, "USAGE: %s --bench [max n from %d to %d]\n", argv[0], BENCH_MIN_N, BENCH_MAX_N);
+        return EXIT_FAILURE;
+    }
+    const double lambdas[] = {0.02, 0.05};
+    const int tslices[] = {8, 64};
+    int numLambdas = sizeof(lambdas) / sizeof(lambdas[0]);
+    int numTslices = sizeof(tslices) / sizeof(tslices[0]);
+
+    FILE *fp = fopen("bench_output.txt", "w");
+    if (fp == NULL) {
+        perror("Error opening file");
+        return EXIT_FAILURE;
+    }
+    fprintf(fp, "-- seed=%d; bound=%d; t_cs=%dms; alpha=%.2f; ncpu=n/10; logging disabled\n",
+        BENCH_SEED, BENCH_BOUND, BENCH_TCS, BENCH_ALPHA);
+    fprintf(fp, "-- peak RSS is the maximum resident set of the process running the case, including its copy of the workload\n\n");
+    fprintf(fp, "%8s %7s %-7s %7s %12s %10s %12s %9s %12s %13s\n",
+        "n", "lambda", "alg", "t_slice", "events", "seconds", "events/s", "ns/event", "peak RSS KB", "allocs/event");
+    int cases = 0;
+    bool failed = false;
+    for (long n = BENCH_MIN_N; n <= maxN && !failed; n *= 10) {
+        for (int l = 0; l < numLambdas && !failed; l++) {
+            Workload workload;
+            generateWorkload(&workload, (int)n, (int)(n / 10), BENCH_SEED, lambdas[l], BENCH_BOUND, true);
+            for (int k = 0; k < ALG_COUNT && !failed; k++) {
+                int variants = usesTimeSlice(k) ? numTslices : 1;
+                for (int t = 0; t < variants; t++) {
+                    SimRun run = {.algorithm = k, .workload = &workload, .tcs = BENCH_TCS, .alpha = BENCH_ALPHA, .tslice = tslices[t]};
+                    BenchResult r;
+                    long peakRss;
+                    if (!runBenchCase(&run, &r, &peakRss)) {
+                        fprintf(stderr, "ERROR: Benchmark of %s failed for n=%ld\n", algorithmName(k), n);
+                        failed = true;
+                        break;
+                    }
+                    char tslice[16] = "-";
+                    if (usesTimeSlice(k)) {
+                        snprintf(tslice, sizeof(tslice), "%d", tslices[t]);
+                    }
+                    double perEvent = r.events > 0 ? 1.0 / r.events : 0.0;
+                    fprintf(fp, "%8ld %7.3f %-7s %7s %12ld %10.4f %12.0f %9.1f %12ld %13.6f\n",
+                        n, lambdas[l], algorithmName(k), tslice, r.events, r.seconds,
+                        r.seconds > 0 ? r.events / r.seconds : 0.0, r.seconds * 1e9 * perEvent,
+                        peakRss, r.allocations * perEvent);
+                    fflush(fp);
+                    cases++;
+                }
+            }
+            freeWorkload(&workload);
+        }
+    }
+    fclose(fp);
+    if (failed) {
+        return EXIT_FAILURE;
+    }
+    printf("<<< -- %d benchmark cases written to bench_output.txt\n", cases);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv){
+    if (argc > 1 && strcmp(argv[1], "--sweep") == 0){
+        return runSweep(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0){
+        return runBatch(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0){
+        return runBench(argc, argv);
+    }
+    if (argc < 9){
+        perror("ERROR: Invalid argument(s)");
+        return EXIT_FAILURE;
+    }
+
+    // Get parameters
+    int n = atoi(*(argv+1));
+    int ncpu = atoi(*(argv+2));
+    int seed = atoi(*(argv+3));
+    double lambda = atof(*(argv+4));
+    int upperBound = atoi(*(argv+5));
+    int tcs = atoi(*(argv+6));
+    double alpha = atof(*(argv+7));
+    int tslice = atoi(*(argv+8));
+    if (!validLambda(lambda) || !validContextSwitch(tcs) || !validAlpha(alpha) || !validTimeSlice(tslice)){
+        return EXIT_FAILURE;
+    }
+    // Optional flags
+    int cores = 1;
+    const char* dumpPath = NULL;
+    const char* replayPath = NULL;
+    const char* importPath = NULL;
+    bool logEvents = LOG_LEVEL >= LOG_TRACE;
+    const char* exportPath = NULL;
+    const char* processExportPath = NULL;
+    const char* latencyExportPath = NULL;
+    int mlfqLevels = 0;
+    const char* mlfqQuanta = NULL;
+    int mlfqBoost = -1;
+    int tickets[2] = {DEFAULT_TICKETS, DEFAULT_TICKETS};
+    bool withDeadlines = false;
+#ifdef STATS
+    bool showStats = false;
+#endif
+    for (int i = 9; i < argc; i++){
+        if (strcmp(argv[i], "--cpus") == 0 && i + 1 < argc){
+            cores = atoi(argv[++i]);
+            if (cores < 1){
+                fprintf(stderr, "ERROR: Number of CPUs < 1\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--dump-workload") == 0 && i + 1 < argc){
+            dumpPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc){
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--import") == 0 && i + 1 < argc){
+            importPath = argv[++i];
+        } else if (strcmp(argv[i], "--no-log") == 0){
+            logEvents = false;
+        } else if (strcmp(argv[i], "--deadlines") == 0){
+            withDeadlines = true;
+        } else if (strcmp(argv[i], "--stats") == 0){
+#ifdef STATS
+            showStats = true;
+#else
+            fprintf(stderr, "ERROR: --stats needs a build with -DSTATS\n");
+            return EXIT_FAILURE;
+#endif
+        } else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc){
+            exportPath = argv[++i];
+        } else if (strcmp(argv[i], "--export-processes") == 0 && i + 1 < argc){
+            processExportPath = argv[++i];
+        } else if (strcmp(argv[i], "--export-latency") == 0 && i + 1 < argc){
+            latencyExportPath = argv[++i];
+        } else if (strcmp(argv[i], "--mlfq-levels") == 0 && i + 1 < argc){
+            mlfqLevels = atoi(argv[++i]);
+            if (mlfqLevels < 1 || mlfqLevels > MLFQ_MAX_LEVELS){
+                fprintf(stderr, "ERROR: Number of MLFQ levels is not in the range 1 to %d\n", MLFQ_MAX_LEVELS);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--mlfq-quanta") == 0 && i + 1 < argc){
+            mlfqQuanta = argv[++i];
+        } else if ((strcmp(argv[i], "--cpu-tickets") == 0 || strcmp(argv[i], "--io-tickets") == 0) && i + 1 < argc){
+            int cls = strcmp(argv[i], "--cpu-tickets") == 0 ? 0 : 1;
+            tickets[cls] = atoi(argv[++i]);
+            if (tickets[cls] < 1){
+                fprintf(stderr, "ERROR: Number of tickets < 1\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--mlfq-boost") == 0 && i + 1 < argc){
+            mlfqBoost = atoi(argv[++i]);
+            if (mlfqBoost < 0){
+                fprintf(stderr, "ERROR: Negative MLFQ boost period\n");
+                return EXIT_FAILURE;
+            }
+        } else {
+            fprintf(stderr, "ERROR: Unknown option %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // MLFQ levels: the quanta list sets the number of levels unless --mlfq-levels does
+    MlfqConfig mlfq;
+    double* quanta = NULL;
+    int numQuanta = 0;
+    if (mlfqQuanta != NULL){
+        numQuanta = parseList(mlfqQuanta, &quanta);
+        if (numQuanta <= 0 || numQuanta > MLFQ_MAX_LEVELS || (mlfqLevels != 0 && numQuanta != mlfqLevels)){
+            fprintf(stderr, "ERROR: Invalid list of MLFQ quanta: %s\n", mlfqQuanta);
+            free(quanta);
+            return EXIT_FAILURE;
+        }
+        mlfqLevels = numQuanta;
+    }
+    defaultMlfqConfig(&mlfq, mlfqLevels != 0 ? mlfqLevels : MLFQ_DEFAULT_LEVELS, tslice);
+    for (int l = 0; l < numQuanta; l++){
+        if (quanta[l] < 1 || quanta[l] > INT_MAX){
+            fprintf(stderr, "ERROR: Invalid list of MLFQ quanta: %s\n", mlfqQuanta);
+            free(quanta);
+            return EXIT_FAILURE;
+        }
+        mlfq.quanta[l] = (int)quanta[l];
+    }
+    free(quanta);
+    if (mlfqBoost >= 0){
+        mlfq.boost = mlfqBoost;
+    }
+
+    // A replayed trace supplies the process set and the parameters it was generated with,
+    // an imported one the process set and a lambda matching its mean CPU burst
+    Workload workload;
+    if (replayPath != NULL && importPath != NULL){
+        fprintf(stderr, "ERROR: --replay and --import are mutually exclusive\n");
+        return EXIT_FAILURE;
+    }
+    // A replayed or imported workload brings its own process counts
+    if (replayPath == NULL && importPath == NULL && !validProcessCounts(n, ncpu)){
+        return EXIT_FAILURE;
+    }
+#ifdef STATS
+    struct timespec phaseStart, phaseEnd;
+    clock_gettime(CLOCK_MONOTONIC, &phaseStart);
+#endif
+    if (importPath != NULL){
+        if (!importWorkload(&workload, importPath)){
+            return EXIT_FAILURE;
+        }
+        n = workload.n;
+        ncpu = workload.ncpu;
+        lambda = workload.lambda;
+    } else if (replayPath != NULL){
+        if (!loadWorkload(&workload, replayPath)){
+            return EXIT_FAILURE;
+        }
+        n = workload.n;
+        ncpu = workload.ncpu;
+        seed = workload.seed;
+        lambda = workload.lambda;
+        upperBound = workload.upperBound;
+    } else {
+        generateWorkload(&workload, n, ncpu, seed, lambda, upperBound, withDeadlines);
+    }
+    if (dumpPath != NULL && !saveWorkload(&workload, dumpPath)){
+        freeWorkload(&workload);
+        return EXIT_FAILURE;
+    }
+#ifdef STATS
+    clock_gettime(CLOCK_MONOTONIC, &phaseEnd);
+    double generationTime = elapsedSeconds(&phaseStart, &phaseEnd);
+#endif
+
+    if (ncpu == 1){
+        printf("<<< -- process set (n=%d) with %d CPU-bound process\n", n, ncpu);
+    } else {
+        printf("<<< -- process set (n=%d) with %d CPU-bound processes\n", n, ncpu);
+    }
+    // A replayed trace of an imported workload carries its names, and has no seed or bound to show
+    if (importPath != NULL || workload.names != NULL){
+        printf("<<< -- imported from %s; lambda=%.6f\n\n", importPath != NULL ? importPath : replayPath, lambda);
+    } else {
+        printf("<<< -- seed=%d; lambda=%.6f; bound=%d\n\n", seed,lambda, upperBound);
+    }
+
+    // Simulation Calcs
+    printWorkload(stdout, &workload);
+
+    printf("<<< PROJECT SIMULATIONS\n");
+    printf("<<< -- t_cs=%dms; alpha=%.2f; t_slice=%dms\n", tcs, alpha, tslice);
+    // The multi-core simulation only implements some algorithms, the others are left out,
+    // as is EDF unless the workload has deadlines
+    Algorithm algorithms[ALG_COUNT];
+    int count = 0;
+    for (int k = 0; k < ALG_COUNT; k++) {
+        if ((cores == 1 || smpSupported(k)) && (!needsDeadlines(k) || workload.deadlines != NULL)) {
+            algorithms[count++] = k;
+        }
+    }
+    if (cores > 1){
+        printf("<<< -- simulating %d CPUs with per-CPU ready queues\n", cores);
+    }
+
+    // Run every algorithm in parallel, each on its own copy of the process state,
+    // while the log sink streams their logs to stdout in order
+    fflush(stdout);
+    LogSink sink;
+    if (logEvents && !startLogSink(&sink, count, STDOUT_FILENO)){
+        freeWorkload(&workload);
+        return EXIT_FAILURE;
+    }
+    SimRun runs[ALG_COUNT];
+    LatencyStats* latency = calloc(count, sizeof(LatencyStats));
+    for (int k = 0; k < count; k++) {
+        runs[k] = (SimRun){.algorithm = algorithms[k], .workload = &workload, .tcs = tcs, .alpha = alpha, .tslice = tslice,
+                           .mlfq = mlfq, .tickets = {tickets[0], tickets[1]}, .cores = cores, .latency = latency + k, .keepProcesses = processExportPath != NULL};
+        if (logEvents){
+            runs[k].log = &sink;
+            runs[k].logRing = sink.rings + k;
+        }
+    }
+    runSimulations(runs, count, defaultThreadCount());
+    if (logEvents){
+        finishLogSink(&sink);
+    }
+
+    // Write to file
+#ifdef STATS
+    clock_gettime(CLOCK_MONOTONIC, &phaseStart);
+#endif
+    // Open the output file for writing.
+    FILE *fp = fopen("simout.txt", "w");
+    if (fp == NULL) {
+        perror("Error opening file");
+        return 1;
+    }
+    writeSimout(fp, &workload, runs, count);
+    fclose(fp);
+    if (exportPath != NULL && !writeExport(exportPath, runs, count, false)) {
+        return EXIT_FAILURE;
+    }
+    if (processExportPath != NULL && !writeExport(processExportPath, runs, count, true)) {
+        return EXIT_FAILURE;
+    }
+    // Per-burst percentiles for other tools
+    if (latencyExportPath != NULL && !writeLatencyCsv(latencyExportPath, runs, count)) {
+        return EXIT_FAILURE;
+    }
+#ifdef STATS
+    clock_gettime(CLOCK_MONOTONIC, &phaseEnd);
+    if (showStats){
+        printStats(stdout, runs, count, generationTime, elapsedSeconds(&phaseStart, &phaseEnd));
+    }
+#endif
+
+    // Clean up
+    for (int k = 0; k < count; k++) {
+        freeSimRun(runs + k);
+    }
+    free(latency);
+    freeWorkload(&workload);
+}